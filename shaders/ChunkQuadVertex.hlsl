@@ -0,0 +1,89 @@
+cbuffer ConstantBuffer : register(b0)
+{
+    matrix World;
+    matrix View;
+    matrix Projection;
+    matrix LightViewProj;
+    float4 LightDir;
+    float4 CameraPos;
+};
+
+cbuffer ChunkBuffer : register(b1)
+{
+    float4 ChunkOffset;
+};
+
+// BlockDatabase colors, indexed by BlockType
+cbuffer BlockColorBuffer : register(b2)
+{
+    float4 BlockColors[7];
+};
+
+// One MeshQuad per instance, six vertices each
+struct VS_INPUT
+{
+    uint4 Block : QUADBLOCK; // x, y, z, face
+    uint4 Info : QUADINFO;   // type, sizeX - 1, sizeY - 1, sizeZ - 1
+    uint VertexID : SV_VertexID;
+};
+
+struct PS_INPUT
+{
+    float4 Position : SV_POSITION;
+    float3 WorldPos : WORLDPOS;
+    float3 Normal : NORMAL;
+    float4 Color : COLOR;
+    float2 TexCoord : TEXCOORD;
+    float4 ShadowPos : SHADOWPOS;
+};
+
+// Same corners, normals and texture coordinates as Chunk::GetFaceCorners
+static const float3 FaceNormals[6] = {
+    float3(0, 0, 1), float3(0, 0, -1), float3(-1, 0, 0),
+    float3(1, 0, 0), float3(0, 1, 0), float3(0, -1, 0)
+};
+
+static const float3 FaceCorners[6][4] = {
+    { float3(0, 0, 1), float3(1, 0, 1), float3(1, 1, 1), float3(0, 1, 1) }, // Front
+    { float3(1, 0, 0), float3(0, 0, 0), float3(0, 1, 0), float3(1, 1, 0) }, // Back
+    { float3(0, 0, 0), float3(0, 0, 1), float3(0, 1, 1), float3(0, 1, 0) }, // Left
+    { float3(1, 0, 1), float3(1, 0, 0), float3(1, 1, 0), float3(1, 1, 1) }, // Right
+    { float3(0, 1, 1), float3(1, 1, 1), float3(1, 1, 0), float3(0, 1, 0) }, // Top
+    { float3(0, 0, 0), float3(1, 0, 0), float3(1, 0, 1), float3(0, 0, 1) }  // Bottom
+};
+
+static const float2 CornerTexCoords[4] = {
+    float2(0, 1), float2(1, 1), float2(1, 0), float2(0, 0)
+};
+
+// The two triangles of a quad, as AppendFace indexes them
+static const uint QuadCorners[6] = { 0, 1, 2, 0, 2, 3 };
+
+PS_INPUT main(VS_INPUT input)
+{
+    PS_INPUT output;
+
+    uint face = input.Block.w;
+    uint corner = QuadCorners[input.VertexID];
+    float3 size = float3(input.Info.yzw) + 1.0f;
+    float3 unit = FaceCorners[face][corner];
+
+    // Texture coordinates repeat once per block across stretched faces
+    float texScaleU = abs(dot(FaceCorners[face][1] - FaceCorners[face][0], size));
+    float texScaleV = abs(dot(FaceCorners[face][2] - FaceCorners[face][1], size));
+
+    float3 position = ChunkOffset.xyz + float3(input.Block.xyz) + unit * size;
+    float4 worldPos = mul(float4(position, 1.0f), World);
+    output.WorldPos = worldPos.xyz;
+
+    float4 viewPos = mul(worldPos, View);
+    output.Position = mul(viewPos, Projection);
+
+    output.Normal = normalize(mul(FaceNormals[face], (float3x3)World));
+    output.Color = BlockColors[input.Info.x];
+    output.TexCoord = CornerTexCoords[corner] * float2(texScaleU, texScaleV);
+
+    output.ShadowPos = mul(worldPos, LightViewProj);
+
+    return output;
+}
@@ -0,0 +1,1614 @@
+#include "Benchmark.h"
+#include "BlockAccessor.h"
+#include "BlockDatabase.h"
+#include "BlockStorage.h"
+#include "ChunkGrid.h"
+#include "ChunkPool.h"
+#include "Chunk.h"
+#include "RenderDistanceTuner.h"
+#include "TerrainGenerator.h"
+#include "World.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::high_resolution_clock;
+
+    const unsigned int kBenchmarkSeed = 12345;
+    const int kBenchmarkRadius = 2; // (2*2+1)^2 = 25 chunks
+
+    double ElapsedMs(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    double MillionsPerSecond(size_t count, double ms) {
+        return ms > 0.0 ? (static_cast<double>(count) / 1.0e6) / (ms / 1000.0) : 0.0;
+    }
+
+    size_t GetChunkBlockIndex(int x, int y, int z) {
+        return (static_cast<size_t>(x) * CHUNK_HEIGHT + y) * CHUNK_SIZE + z;
+    }
+
+    // A chunk's quads expanded to the vertices the DX12 renderer draws
+    template <typename ChunkT>
+    std::vector<Vertex> SolidVertices(const ChunkT& chunk) {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        chunk.AppendSolidMesh(vertices, indices);
+        return vertices;
+    }
+
+    template <typename ChunkT>
+    std::vector<Vertex> TransparentVertices(const ChunkT& chunk) {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        chunk.AppendTransparentMesh(vertices, indices);
+        return vertices;
+    }
+
+    // Order-independent hash of a mesh's quads, so meshers that emit the
+    // same faces in a different order produce the same fingerprint
+    uint64_t MeshFingerprint(const std::vector<Vertex>& vertices) {
+        uint64_t fingerprint = 0;
+        for (size_t i = 0; i + 3 < vertices.size(); i += 4) {
+            uint64_t hash = 14695981039346656037ull;
+            const Vertex& v = vertices[i];
+            const float values[] = { v.position.x, v.position.y, v.position.z,
+                                     v.normal.x, v.normal.y, v.normal.z,
+                                     v.color.x, v.color.y, v.color.z, v.color.w };
+            for (float value : values) {
+                hash ^= static_cast<uint64_t>(static_cast<int64_t>(value * 1024.0f));
+                hash *= 1099511628211ull;
+            }
+            fingerprint += hash;
+        }
+        return fingerprint;
+    }
+
+    // MeshFingerprint of a mesh with every quad cut back into unit faces,
+    // so a greedy mesh can be compared with a per-face one
+    uint64_t UnitFaceFingerprint(const std::vector<Vertex>& vertices) {
+        std::vector<Vertex> unitFaces;
+        for (size_t i = 0; i + 3 < vertices.size(); i += 4) {
+            const Vertex& corner = vertices[i];
+            Vector3 edgeU = vertices[i + 1].position - corner.position;
+            Vector3 edgeV = vertices[i + 3].position - corner.position;
+            int sizeU = static_cast<int>(edgeU.length() + 0.5f);
+            int sizeV = static_cast<int>(edgeV.length() + 0.5f);
+            // Edges are axis-aligned, so the unit steps are exact
+            Vector3 stepU = edgeU / static_cast<float>(sizeU);
+            Vector3 stepV = edgeV / static_cast<float>(sizeV);
+            for (int u = 0; u < sizeU; u++) {
+                for (int v = 0; v < sizeV; v++) {
+                    Vertex face = corner;
+                    face.position = corner.position + stepU * static_cast<float>(u) + stepV * static_cast<float>(v);
+                    unitFaces.insert(unitFaces.end(), 4, face);
+                }
+            }
+        }
+        return MeshFingerprint(unitFaces);
+    }
+
+    // Whether two meshes hold the same quads byte for byte, in any order
+    bool SameQuads(const std::vector<Vertex>& a, const std::vector<Vertex>& b) {
+        if (a.size() != b.size()) {
+            return false;
+        }
+        auto sortedQuads = [](const std::vector<Vertex>& vertices) {
+            std::vector<std::string> quads;
+            for (size_t i = 0; i + 3 < vertices.size(); i += 4) {
+                quads.emplace_back(reinterpret_cast<const char*>(&vertices[i]), 4 * sizeof(Vertex));
+            }
+            std::sort(quads.begin(), quads.end());
+            return quads;
+        };
+        return sortedQuads(a) == sortedQuads(b);
+    }
+
+    std::vector<std::unique_ptr<Chunk>> GenerateChunks(int radius) {
+        TerrainGenerator generator(kBenchmarkSeed);
+        std::vector<std::unique_ptr<Chunk>> chunks;
+        for (int cx = -radius; cx <= radius; cx++) {
+            for (int cz = -radius; cz <= radius; cz++) {
+                auto chunk = std::make_unique<Chunk>(cx, cz);
+                generator.GenerateChunk(chunk.get());
+                chunks.push_back(std::move(chunk));
+            }
+        }
+        return chunks;
+    }
+
+    // Runs World::Update until everything in range is generated and meshed;
+    // returns the number of updates it took
+    int LoadAround(World& world, const Vector3& position) {
+        int updates = 0;
+        do {
+            world.Update(position, nullptr);
+            updates++;
+            // Let worker threads run on machines with few cores
+            std::this_thread::yield();
+        } while (world.HasPendingWork());
+        return updates;
+    }
+
+    size_t GetPendingChunks(const World::DebugStats& stats) {
+        size_t pending = 0;
+        for (size_t count : stats.scheduler.pending) {
+            pending += count;
+        }
+        return pending;
+    }
+
+    template <typename Storage>
+    void BenchmarkStorage(std::FILE* out, const char* name, const std::vector<std::unique_ptr<Chunk>>& chunks) {
+        const size_t blockCount = static_cast<size_t>(CHUNK_SIZE) * CHUNK_HEIGHT * CHUNK_SIZE;
+
+        // Copy the generated terrain in, timing SetBlock
+        std::vector<Storage> storages;
+        storages.reserve(chunks.size());
+        auto start = Clock::now();
+        for (const auto& chunk : chunks) {
+            storages.emplace_back(blockCount);
+            Storage& storage = storages.back();
+            for (int x = 0; x < CHUNK_SIZE; x++) {
+                for (int y = 0; y < CHUNK_HEIGHT; y++) {
+                    for (int z = 0; z < CHUNK_SIZE; z++) {
+                        storage.Set(GetChunkBlockIndex(x, y, z), chunk->GetBlock(x, y, z).type);
+                    }
+                }
+            }
+        }
+        double setMs = ElapsedMs(start);
+
+        size_t totalBytes = 0;
+        for (const auto& storage : storages) {
+            totalBytes += storage.GetMemoryUsage();
+        }
+
+        // Sequential reads
+        uint64_t checksum = 0;
+        start = Clock::now();
+        for (const auto& storage : storages) {
+            for (size_t i = 0; i < blockCount; i++) {
+                checksum += static_cast<uint64_t>(storage.Get(i));
+            }
+        }
+        double seqMs = ElapsedMs(start);
+
+        // Scattered reads (LCG keeps the sequence identical for every storage type)
+        uint32_t rng = 1;
+        start = Clock::now();
+        for (const auto& storage : storages) {
+            for (size_t i = 0; i < blockCount; i++) {
+                rng = rng * 1664525u + 1013904223u;
+                checksum += static_cast<uint64_t>(storage.Get(rng % blockCount));
+            }
+        }
+        double randMs = ElapsedMs(start);
+
+        size_t accesses = blockCount * storages.size();
+        std::fprintf(out, "  %-8s %8zu bytes/chunk  set %7.1f M/s  get(seq) %7.1f M/s  get(rand) %7.1f M/s  [checksum %llu]\n",
+                     name, totalBytes / storages.size(),
+                     MillionsPerSecond(accesses, setMs),
+                     MillionsPerSecond(accesses, seqMs),
+                     MillionsPerSecond(accesses, randMs),
+                     static_cast<unsigned long long>(checksum));
+    }
+
+    void BenchmarkBlockStorage(std::FILE* out, const std::vector<std::unique_ptr<Chunk>>& chunks) {
+        std::fprintf(out, "Block storage (%zu generated chunks)\n", chunks.size());
+        BenchmarkStorage<DenseBlockStorage>(out, "dense", chunks);
+        BenchmarkStorage<PaletteBlockStorage>(out, "palette", chunks);
+
+        // The chunks themselves: 16^3 sections over palette storage
+        size_t chunkBytes = 0;
+        int emptySections = 0;
+        int uniformSections = 0;
+        int sharedSections = 0;
+        for (const auto& chunk : chunks) {
+            chunkBytes += chunk->GetBlockMemoryUsage();
+            for (int s = 0; s < SECTIONS_PER_CHUNK; s++) {
+                const ChunkSection& section = chunk->GetSection(s);
+                if (section.IsEmpty()) {
+                    emptySections++;
+                } else if (section.IsUniform()) {
+                    uniformSections++;
+                } else if (section.IsShared()) {
+                    sharedSections++;
+                }
+            }
+        }
+        std::fprintf(out, "  %-8s %8zu bytes/chunk  (%d empty, %d uniform, %d shared of %zu sections)\n",
+                     "sections", chunkBytes / chunks.size(), emptySections, uniformSections, sharedSections,
+                     chunks.size() * SECTIONS_PER_CHUNK);
+
+        const size_t blockCount = static_cast<size_t>(CHUNK_SIZE) * CHUNK_HEIGHT * CHUNK_SIZE;
+        uint64_t checksum = 0;
+        auto start = Clock::now();
+        for (const auto& chunk : chunks) {
+            for (int x = 0; x < CHUNK_SIZE; x++) {
+                for (int y = 0; y < CHUNK_HEIGHT; y++) {
+                    for (int z = 0; z < CHUNK_SIZE; z++) {
+                        checksum += static_cast<uint64_t>(chunk->GetBlock(x, y, z).type);
+                    }
+                }
+            }
+        }
+        double getMs = ElapsedMs(start);
+        std::fprintf(out, "  Chunk::GetBlock %7.1f M/s  [checksum %llu]\n",
+                     MillionsPerSecond(blockCount * chunks.size(), getMs),
+                     static_cast<unsigned long long>(checksum));
+        std::fprintf(out, "\n");
+    }
+
+    // A chunk column copied into palette sections ordered by Layout, so every
+    // layout policy can be measured in one run regardless of ChunkLayout
+    template <typename Layout>
+    class LayoutColumn {
+    public:
+        explicit LayoutColumn(const Chunk& chunk) {
+            m_sections.assign(SECTIONS_PER_CHUNK, PaletteBlockStorage(static_cast<size_t>(SECTION_VOLUME)));
+            for (int x = 0; x < CHUNK_SIZE; x++) {
+                for (int y = 0; y < CHUNK_HEIGHT; y++) {
+                    for (int z = 0; z < CHUNK_SIZE; z++) {
+                        m_sections[GetSectionIndex(x, y, z)].Set(
+                            Layout::Index(x & SECTION_MASK, y & SECTION_MASK, z & SECTION_MASK),
+                            chunk.GetBlock(x, y, z).type);
+                    }
+                }
+            }
+        }
+
+        BlockType Get(int x, int y, int z) const {
+            if (x < 0 || x >= CHUNK_SIZE || y < 0 || y >= CHUNK_HEIGHT || z < 0 || z >= CHUNK_SIZE) {
+                return BlockType::Air;
+            }
+            return m_sections[GetSectionIndex(x, y, z)].Get(
+                Layout::Index(x & SECTION_MASK, y & SECTION_MASK, z & SECTION_MASK));
+        }
+
+    private:
+        static int GetSectionIndex(int x, int y, int z) {
+            return Chunk::GetSectionIndex(x >> SECTION_SHIFT, y >> SECTION_SHIFT, z >> SECTION_SHIFT);
+        }
+
+        std::vector<PaletteBlockStorage> m_sections;
+    };
+
+    template <typename Layout>
+    void BenchmarkLayout(std::FILE* out, const std::vector<std::unique_ptr<Chunk>>& chunks) {
+        std::vector<LayoutColumn<Layout>> columns;
+        columns.reserve(chunks.size());
+        for (const auto& chunk : chunks) {
+            columns.emplace_back(*chunk);
+        }
+
+        // Face visibility pass with the same neighbor reads as Chunk::ShouldRenderFace
+        static const int offsets[6][3] = { {0, 0, 1}, {0, 0, -1}, {-1, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, -1, 0} };
+        uint64_t faces = 0;
+        auto start = Clock::now();
+        for (const auto& column : columns) {
+            for (int x = 0; x < CHUNK_SIZE; x++) {
+                for (int y = 0; y < CHUNK_HEIGHT; y++) {
+                    for (int z = 0; z < CHUNK_SIZE; z++) {
+                        BlockType type = column.Get(x, y, z);
+                        if (type == BlockType::Air) continue;
+                        for (const auto& offset : offsets) {
+                            Block neighbor(column.Get(x + offset[0], y + offset[1], z + offset[2]));
+                            if (neighbor.IsTransparent() && neighbor.type != type) {
+                                faces++;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        double faceMs = ElapsedMs(start) / columns.size();
+
+        // Rays marched in 0.1 steps like World::Raycast, kept inside each column
+        const int raysPerColumn = 512;
+        uint64_t hits = 0;
+        uint32_t rng = 7;
+        auto nextFloat = [&rng]() {
+            rng = rng * 1664525u + 1013904223u;
+            return static_cast<float>(rng >> 8) / static_cast<float>(1u << 24);
+        };
+        start = Clock::now();
+        for (const auto& column : columns) {
+            for (int r = 0; r < raysPerColumn; r++) {
+                Vector3 pos(nextFloat() * CHUNK_SIZE, 110.0f, nextFloat() * CHUNK_SIZE);
+                Vector3 step = Vector3(nextFloat() - 0.5f, -1.0f, nextFloat() - 0.5f).normalized() * 0.1f;
+                for (float dist = 0; dist < 80.0f; dist += 0.1f) {
+                    pos = pos + step;
+                    Block block(column.Get(static_cast<int>(std::floor(pos.x)),
+                                           static_cast<int>(std::floor(pos.y)),
+                                           static_cast<int>(std::floor(pos.z))));
+                    if (!block.IsTransparent()) {
+                        hits++;
+                        break;
+                    }
+                }
+            }
+        }
+        double rayMs = ElapsedMs(start);
+
+        std::fprintf(out, "  %-8s face pass %.3f ms/chunk (%llu faces)  rays %.2f M/s (%llu hits)\n",
+                     Layout::kName, faceMs, static_cast<unsigned long long>(faces),
+                     MillionsPerSecond(columns.size() * raysPerColumn, rayMs),
+                     static_cast<unsigned long long>(hits));
+    }
+
+    void BenchmarkLayouts(std::FILE* out, const std::vector<std::unique_ptr<Chunk>>& chunks) {
+        std::fprintf(out, "Section layouts (compiled ChunkLayout: %s)\n", ChunkLayout::kName);
+        BenchmarkLayout<XMajorLayout>(out, chunks);
+        BenchmarkLayout<ColumnLayout>(out, chunks);
+        BenchmarkLayout<MortonBrickLayout>(out, chunks);
+        std::fprintf(out, "\n");
+    }
+
+    void BenchmarkRaycast(std::FILE* out) {
+        World world(kBenchmarkSeed);
+        Vector3 center(0.0f, 100.0f, 0.0f);
+
+        auto start = Clock::now();
+        int loadUpdates = LoadAround(world, center);
+        double loadMs = ElapsedMs(start);
+
+        const int rayCount = 20000;
+        int hits = 0;
+        uint32_t rng = 11;
+        auto nextFloat = [&rng]() {
+            rng = rng * 1664525u + 1013904223u;
+            return static_cast<float>(rng >> 8) / static_cast<float>(1u << 24);
+        };
+        start = Clock::now();
+        for (int i = 0; i < rayCount; i++) {
+            Vector3 origin(nextFloat() * 64.0f - 32.0f, 105.0f, nextFloat() * 64.0f - 32.0f);
+            Vector3 direction(nextFloat() * 2.0f - 1.0f, -nextFloat(), nextFloat() * 2.0f - 1.0f);
+            Vector3 hitPos, hitNormal;
+            Block hitBlock;
+            if (world.Raycast(origin, direction, 50.0f, hitPos, hitNormal, hitBlock)) {
+                hits++;
+            }
+        }
+        double rayMs = ElapsedMs(start);
+
+        World::DebugStats stats = world.GetDebugStats();
+        std::fprintf(out, "World (%s layout)\n", ChunkLayout::kName);
+        std::fprintf(out, "  initial load: %d chunks in %.1f ms over %d updates\n", stats.chunkCount, loadMs, loadUpdates);
+        std::fprintf(out, "  World::Raycast %.1f us/ray (%d of %d hit)\n\n",
+                     rayMs * 1000.0 / rayCount, hits, rayCount);
+    }
+
+    // Flies along +x at the player's fly speed, one World::Update per 60 Hz
+    // frame: on the main thread with and without the per-frame load budget,
+    // then with worker threads
+    void BenchmarkFlight(std::FILE* out) {
+        const float flySpeed = 20.0f;
+        const float frameTime = 1.0f / 60.0f;
+        const int frames = 600;
+        std::fprintf(out, "Flight (%.0f blocks/s for %d frames)\n", flySpeed, frames);
+
+        const ChunkLoadBudget budgets[3] = { { 0.0, 0.0, 0.0 }, ChunkLoadBudget(), ChunkLoadBudget() };
+        const int workerThreads[3] = { 0, 0, -1 };
+        const char* names[3] = { "unbudgeted", "budgeted", "workers" };
+        for (int i = 0; i < 3; i++) {
+            World world(kBenchmarkSeed, workerThreads[i]);
+            world.SetLoadBudget(budgets[i]);
+            Vector3 position(0.0f, 100.0f, 0.0f);
+            LoadAround(world, position);
+
+            double totalMs = 0.0;
+            double worstMs = 0.0;
+            size_t worstPending = 0;
+            for (int frame = 0; frame < frames; frame++) {
+                position.x += flySpeed * frameTime;
+                auto start = Clock::now();
+                world.Update(position, nullptr);
+                double ms = ElapsedMs(start);
+                totalMs += ms;
+                worstMs = std::max(worstMs, ms);
+                worstPending = std::max(worstPending, GetPendingChunks(world.GetDebugStats()));
+            }
+
+            World::DebugStats stats = world.GetDebugStats();
+            std::fprintf(out, "  %-10s World::Update avg %.3f ms  worst %.3f ms  (at most %zu chunks pending)\n",
+                         names[i], totalMs / frames, worstMs, worstPending);
+            std::fprintf(out, "  %-10s chunk pool: %llu hits  %llu misses  %zu free  %zu slabs\n",
+                         "", static_cast<unsigned long long>(stats.chunkPoolHits),
+                         static_cast<unsigned long long>(stats.chunkPoolMisses),
+                         stats.chunkPoolFree, stats.chunkPoolSlabs);
+        }
+        std::fprintf(out, "\n");
+    }
+
+    // World-style block lookups through the chunk grid and through the
+    // std::map it replaced, over the same render-distance square of chunks
+    void BenchmarkChunkLookup(std::FILE* out) {
+        const int radius = 8;
+        const int lookups = 4000000;
+        TerrainGenerator generator(kBenchmarkSeed);
+        ChunkPool pool;
+        ChunkGrid grid(radius + 2);
+        std::map<std::pair<int, int>, Chunk*> map;
+        for (int cx = -radius; cx <= radius; cx++) {
+            for (int cz = -radius; cz <= radius; cz++) {
+                ChunkPool::Handle chunk = pool.Acquire(cx, cz);
+                generator.GenerateChunk(chunk.get());
+                map[std::make_pair(cx, cz)] = grid.Insert(std::move(chunk));
+            }
+        }
+
+        std::vector<int> coords(static_cast<size_t>(lookups) * 3);
+        uint32_t rng = 11;
+        for (size_t i = 0; i < coords.size(); i += 3) {
+            rng = rng * 1664525u + 1013904223u;
+            coords[i] = static_cast<int>((rng >> 8) % ((2 * radius + 1) * CHUNK_SIZE)) - radius * CHUNK_SIZE;
+            rng = rng * 1664525u + 1013904223u;
+            coords[i + 1] = static_cast<int>((rng >> 8) % 128);
+            rng = rng * 1664525u + 1013904223u;
+            coords[i + 2] = static_cast<int>((rng >> 8) % ((2 * radius + 1) * CHUNK_SIZE)) - radius * CHUNK_SIZE;
+        }
+
+        auto timeLookups = [&](auto&& findChunk, uint64_t& checksum) {
+            checksum = 0;
+            auto start = Clock::now();
+            for (size_t i = 0; i < coords.size(); i += 3) {
+                int x = coords[i];
+                int z = coords[i + 2];
+                const Chunk* chunk = findChunk(x >> DefaultChunkShape::SizeShift, z >> DefaultChunkShape::SizeShift);
+                if (chunk) {
+                    checksum += static_cast<uint64_t>(chunk->GetBlock(x & DefaultChunkShape::SizeMask, coords[i + 1],
+                                                                      z & DefaultChunkShape::SizeMask).type);
+                }
+            }
+            return ElapsedMs(start);
+        };
+
+        uint64_t mapChecksum = 0;
+        uint64_t gridChecksum = 0;
+        double mapMs = timeLookups([&map](int cx, int cz) -> const Chunk* {
+            auto it = map.find(std::make_pair(cx, cz));
+            return it != map.end() ? it->second : nullptr;
+        }, mapChecksum);
+        double gridMs = timeLookups([&grid](int cx, int cz) -> const Chunk* {
+            return grid.Find(cx, cz);
+        }, gridChecksum);
+
+        // Sliding the window one chunk at a time
+        const int slides = 256;
+        auto start = Clock::now();
+        for (int i = 1; i <= slides; i++) {
+            grid.Recenter(i % 64, (i / 64) % 2);
+        }
+        double slideUs = ElapsedMs(start) * 1000.0 / slides;
+        grid.Recenter(0, 0);
+
+        // World::Update with nothing to load or mesh: just the chunk walk
+        World world(kBenchmarkSeed, 0);
+        Vector3 position(0.0f, 100.0f, 0.0f);
+        LoadAround(world, position);
+        const int frames = 200;
+        start = Clock::now();
+        for (int frame = 0; frame < frames; frame++) {
+            world.Update(position, nullptr);
+        }
+        double updateMs = ElapsedMs(start) / frames;
+
+        // Neighborhood walk over the 3x3 chunks around the origin
+        BlockAccessor region = world.GetRegion(0, 0);
+        BlockBox box = region.GetBounds();
+        box.maxY = 127;
+        const int passes = 10;
+        uint64_t worldChecksum = 0;
+        start = Clock::now();
+        for (int pass = 0; pass < passes; pass++) {
+            for (int x = box.minX; x <= box.maxX; x++) {
+                for (int y = box.minY; y <= box.maxY; y++) {
+                    for (int z = box.minZ; z <= box.maxZ; z++) {
+                        worldChecksum += static_cast<uint64_t>(world.GetBlock(x, y, z).type);
+                    }
+                }
+            }
+        }
+        double worldMs = ElapsedMs(start);
+
+        uint64_t accessorChecksum = 0;
+        start = Clock::now();
+        for (int pass = 0; pass < passes; pass++) {
+            for (int x = box.minX; x <= box.maxX; x++) {
+                for (int y = box.minY; y <= box.maxY; y++) {
+                    for (int z = box.minZ; z <= box.maxZ; z++) {
+                        accessorChecksum += static_cast<uint64_t>(region.Get(x, y, z));
+                    }
+                }
+            }
+        }
+        double accessorMs = ElapsedMs(start);
+
+        uint64_t readChecksum = 0;
+        std::vector<BlockType> blocks;
+        start = Clock::now();
+        for (int pass = 0; pass < passes; pass++) {
+            region.Read(box, blocks);
+            for (BlockType type : blocks) {
+                readChecksum += static_cast<uint64_t>(type);
+            }
+        }
+        double readMs = ElapsedMs(start);
+        const size_t regionBlocks = box.GetVolume() * passes;
+
+        // Player ground check: the downward raycast it used to make against
+        // pinning the region and reading the column below the eye
+        const int probes = 100000;
+        const float playerHeight = 1.7f;
+        std::vector<Vector3> eyes(probes);
+        uint32_t probeRng = 1;
+        for (Vector3& eye : eyes) {
+            probeRng = probeRng * 1664525u + 1013904223u;
+            int x = static_cast<int>(probeRng >> 24) % (3 * CHUNK_SIZE) - CHUNK_SIZE;
+            int z = static_cast<int>((probeRng >> 16) & 0xFF) % (3 * CHUNK_SIZE) - CHUNK_SIZE;
+            float above = static_cast<float>((probeRng >> 8) & 0xFF) / 256.0f;
+            eye = Vector3(x + 0.5f, world.GetTerrainHeight(x, z) + 1.0f + playerHeight + above, z + 0.5f);
+        }
+        int64_t rayGround = 0;
+        start = Clock::now();
+        for (const Vector3& eye : eyes) {
+            Vector3 hitPos, hitNormal;
+            Block hitBlock;
+            bool hit = world.Raycast(eye, Vector3(0, -1, 0), playerHeight + 0.3f, hitPos, hitNormal, hitBlock);
+            rayGround += hit ? static_cast<int>(hitPos.y) : -1;
+        }
+        double rayMs = ElapsedMs(start);
+
+        int64_t regionGround = 0;
+        start = Clock::now();
+        for (const Vector3& eye : eyes) {
+            int blockX = static_cast<int>(std::floor(eye.x));
+            int blockZ = static_cast<int>(std::floor(eye.z));
+            int topY = static_cast<int>(std::floor(eye.y - 0.1f));
+            int bottomY = static_cast<int>(std::floor(eye.y - (playerHeight + 0.3f)));
+            int groundY = world.GetRegion(blockX, blockZ).FindTopOpaque(blockX, blockZ, bottomY, topY);
+            regionGround += groundY >= bottomY ? groundY : -1;
+        }
+        double probeMs = ElapsedMs(start);
+
+        // Tree crown reads as terrain generation makes them, over every tree
+        // site of the 3x3 chunks: per block through Chunk::GetBlock against
+        // ForEach over the crown box
+        struct Crown {
+            const Chunk* chunk;
+            int x, y, z;
+        };
+        std::vector<Crown> crowns;
+        for (int cx = -1; cx <= 1; cx++) {
+            for (int cz = -1; cz <= 1; cz++) {
+                const Chunk* chunk = world.FindChunk(cx, cz);
+                if (!chunk) continue;
+                for (int x = 2; x < CHUNK_SIZE; x += 4) {
+                    if (x % 16 >= 14) continue;
+                    for (int z = 2; z < CHUNK_SIZE; z += 4) {
+                        if (z % 16 >= 14) continue;
+                        crowns.push_back({chunk, x, chunk->GetHeight(x, z) + 6, z});
+                    }
+                }
+            }
+        }
+        const int crownPasses = 200;
+        uint64_t blockAir = 0;
+        start = Clock::now();
+        for (int pass = 0; pass < crownPasses; pass++) {
+            for (const Crown& crown : crowns) {
+                for (int dx = -2; dx <= 2; dx++) {
+                    for (int dy = -2; dy <= 2; dy++) {
+                        for (int dz = -2; dz <= 2; dz++) {
+                            int lx = crown.x + dx;
+                            int ly = crown.y + dy;
+                            int lz = crown.z + dz;
+                            if (dx * dx + dy * dy + dz * dz <= 8 && crown.chunk->IsBlockInBounds(lx, ly, lz) &&
+                                crown.chunk->GetBlock(lx, ly, lz).IsAir()) {
+                                blockAir++;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        double crownBlockMs = ElapsedMs(start);
+
+        uint64_t crownAir = 0;
+        start = Clock::now();
+        for (int pass = 0; pass < crownPasses; pass++) {
+            const Chunk* pinned = nullptr;
+            BlockAccessor crownRegion(*crowns.front().chunk);
+            for (const Crown& crown : crowns) {
+                // Pinned once per chunk, as GenerateTrees does
+                if (crown.chunk != pinned) {
+                    crownRegion = BlockAccessor(*crown.chunk);
+                    pinned = crown.chunk;
+                }
+                int originX = crown.chunk->GetChunkX() * CHUNK_SIZE;
+                int originZ = crown.chunk->GetChunkZ() * CHUNK_SIZE;
+                BlockBox crownBox = {
+                    originX + std::max(crown.x - 2, 0), crown.y - 2, originZ + std::max(crown.z - 2, 0),
+                    originX + std::min(crown.x + 2, CHUNK_SIZE - 1), crown.y + 2, originZ + std::min(crown.z + 2, CHUNK_SIZE - 1)
+                };
+                crownRegion.ForEach(crownBox, [&](int worldX, int y, int worldZ, BlockType type) {
+                    int dx = worldX - originX - crown.x;
+                    int dy = y - crown.y;
+                    int dz = worldZ - originZ - crown.z;
+                    if (type == BlockType::Air && dx * dx + dy * dy + dz * dz <= 8) {
+                        crownAir++;
+                    }
+                });
+            }
+        }
+        double crownForEachMs = ElapsedMs(start);
+
+        std::fprintf(out, "Chunk lookup (%zu chunks, %d-wide grid window)\n", grid.GetCount(), grid.GetWindowSize());
+        std::fprintf(out, "  GetBlock via std::map  %7.1f M/s  [checksum %llu]\n",
+                     MillionsPerSecond(lookups, mapMs), static_cast<unsigned long long>(mapChecksum));
+        std::fprintf(out, "  GetBlock via grid      %7.1f M/s  [checksum %llu]\n",
+                     MillionsPerSecond(lookups, gridMs), static_cast<unsigned long long>(gridChecksum));
+        std::fprintf(out, "  grid recenter %.1f us/chunk step  steady World::Update %.3f ms\n", slideUs, updateMs);
+        std::fprintf(out, "  3x3 region walk: World::GetBlock %.1f M/s  BlockAccessor::Get %.1f M/s  Read %.1f M/s  [checksums %llu %llu %llu]\n",
+                     MillionsPerSecond(regionBlocks, worldMs), MillionsPerSecond(regionBlocks, accessorMs),
+                     MillionsPerSecond(regionBlocks, readMs),
+                     static_cast<unsigned long long>(worldChecksum),
+                     static_cast<unsigned long long>(accessorChecksum),
+                     static_cast<unsigned long long>(readChecksum));
+        std::fprintf(out, "  player ground check: Raycast %.0f ns  BlockAccessor %.0f ns (%.1fx)  ground %s\n",
+                     rayMs * 1e6 / probes, probeMs * 1e6 / probes, rayMs / probeMs,
+                     rayGround == regionGround ? "same" : "DIFFERENT");
+        std::fprintf(out, "  tree crowns (%zu): Chunk::GetBlock %.0f ns  BlockAccessor::ForEach %.0f ns (%.1fx)  air cells %s\n\n",
+                     crowns.size(), crownBlockMs * 1e6 / (crowns.size() * crownPasses),
+                     crownForEachMs * 1e6 / (crowns.size() * crownPasses), crownBlockMs / crownForEachMs,
+                     blockAir == crownAir ? "same" : "DIFFERENT");
+    }
+
+    // Walks back and forth over a 4-chunk stretch so chunks keep leaving and
+    // re-entering the load window
+    void BenchmarkBorderCrossing(std::FILE* out) {
+        World world(kBenchmarkSeed, 0);
+        // Every crossing loads its whole new row, as the cold cache is under test
+        world.SetLoadBudget({ 0.0, 0.0, 0.0 });
+        Vector3 position(8.0f, 100.0f, 8.0f);
+        LoadAround(world, position);
+
+        const int crossings = 8;
+        const int stepsPerCrossing = 4;
+        int updates = 0;
+        double totalMs = 0.0;
+        double worstMs = 0.0;
+        for (int crossing = 0; crossing < crossings; crossing++) {
+            float direction = (crossing % 2 == 0) ? 1.0f : -1.0f;
+            for (int step = 0; step < stepsPerCrossing; step++) {
+                position.x += direction * CHUNK_SIZE;
+                auto start = Clock::now();
+                world.Update(position, nullptr);
+                double ms = ElapsedMs(start);
+                totalMs += ms;
+                worstMs = std::max(worstMs, ms);
+                updates++;
+            }
+        }
+
+        World::DebugStats stats = world.GetDebugStats();
+        const ChunkCache::Stats& cache = stats.coldCache;
+        uint64_t lookups = cache.hits + cache.misses;
+        std::fprintf(out, "Border crossing (%d crossings of %d chunks)\n", crossings, stepsPerCrossing);
+        std::fprintf(out, "  World::Update avg %.3f ms  worst %.3f ms\n", totalMs / updates, worstMs);
+        std::fprintf(out, "  cold cache: %.1f%% hit rate (%llu hits, %llu misses)  %zu chunks in %zu KB  %llu evictions\n",
+                     lookups ? 100.0 * cache.hits / lookups : 0.0,
+                     static_cast<unsigned long long>(cache.hits),
+                     static_cast<unsigned long long>(cache.misses),
+                     cache.entryCount, cache.byteCount / 1024,
+                     static_cast<unsigned long long>(cache.evictions));
+        std::fprintf(out, "  decompress %.3f ms/chunk  compress %.3f ms/chunk\n",
+                     cache.hits ? cache.decompressMs / cache.hits : 0.0,
+                     cache.stores ? cache.compressMs / cache.stores : 0.0);
+
+        // An edited chunk must survive a cache with no budget at all
+        World edited(kBenchmarkSeed, 0);
+        edited.SetLoadBudget({ 0.0, 0.0, 0.0 });
+        edited.SetColdCacheBudget(0);
+        position = Vector3(8.0f, 100.0f, 8.0f);
+        LoadAround(edited, position);
+        edited.SetBlock(8, 250, 8, BlockType::Torch);
+        size_t mostModified = 0;
+        for (int step = 0; step < 2 * stepsPerCrossing; step++) {
+            position.x += (step < stepsPerCrossing ? 1.0f : -1.0f) * CHUNK_SIZE * 4;
+            LoadAround(edited, position);
+            mostModified = std::max(mostModified, edited.GetDebugStats().coldCache.modifiedCount);
+        }
+        std::fprintf(out, "  0-byte budget: edit %s  %llu evictions  at most %zu modified chunks held\n\n",
+                     edited.GetBlock(8, 250, 8).type == BlockType::Torch ? "kept" : "LOST",
+                     static_cast<unsigned long long>(edited.GetDebugStats().coldCache.evictions), mostModified);
+    }
+
+    // Flies with a tight memory budget and reports how well it was held
+    void BenchmarkMemoryBudget(std::FILE* out) {
+        const size_t budget = 128 * 1024 * 1024;
+        // On the main thread, so every frame loads what it would have
+        World world(kBenchmarkSeed, 0);
+        world.SetMemoryBudget(budget);
+        world.SetCpuMeshesRequired(false);
+
+        Vector3 position(0.0f, 100.0f, 0.0f);
+        size_t peakBytes = 0;
+        for (int frame = 0; frame < 300; frame++) {
+            position.x += 20.0f / 60.0f;
+            world.Update(position, nullptr);
+            peakBytes = std::max(peakBytes, world.GetDebugStats().memory.GetTotal());
+        }
+
+        World::DebugStats stats = world.GetDebugStats();
+        const double mb = 1.0 / (1024.0 * 1024.0);
+        std::fprintf(out, "Memory budget (%.0f MB, flying)\n", budget * mb);
+        std::fprintf(out, "  peak %.1f MB  now %.1f MB (blocks %.1f  cpu mesh %.1f  gpu mesh %.1f  cold %.1f)\n",
+                     peakBytes * mb, stats.memory.GetTotal() * mb,
+                     stats.memory.Get(MemoryCategory::BlockData) * mb,
+                     stats.memory.Get(MemoryCategory::CpuMesh) * mb,
+                     stats.memory.Get(MemoryCategory::GpuMesh) * mb,
+                     stats.memory.Get(MemoryCategory::ColdCache) * mb);
+        std::fprintf(out, "  %d chunks loaded  %llu CPU meshes released  %llu chunks evicted\n\n",
+                     stats.chunkCount,
+                     static_cast<unsigned long long>(stats.cpuMeshReleases),
+                     static_cast<unsigned long long>(stats.budgetEvictions));
+    }
+
+    // Flies fast on the main thread under the default load budget, looking
+    // along the flight path and then sideways, with and without prefetching
+    void BenchmarkPrefetch(std::FILE* out) {
+        const float flySpeed = 40.0f;
+        const float frameTime = 1.0f / 60.0f;
+        const int frames = 600;
+        std::fprintf(out, "Prefetch (%.0f blocks/s for %d frames, main thread, default budget)\n", flySpeed, frames);
+
+        const Vector3 views[2] = { Vector3(1, 0, 0), Vector3(0, 0, 1) };
+        const char* viewNames[2] = { "ahead", "sideways" };
+        for (int view = 0; view < 2; view++) {
+            for (int enabled = 0; enabled < 2; enabled++) {
+                World world(kBenchmarkSeed, 0);
+                ChunkPrefetchPolicy policy;
+                policy.enabled = enabled != 0;
+                world.SetPrefetchPolicy(policy);
+                world.SetViewDirection(views[view]);
+                Vector3 position(0.0f, 100.0f, 0.0f);
+                LoadAround(world, position);
+                uint64_t lateBefore = world.GetDebugStats().chunksVisibleBeforeMeshed;
+
+                Vector3 velocity(flySpeed, 0.0f, 0.0f);
+                world.SetPlayerVelocity(velocity);
+                double worstMs = 0.0;
+                size_t worstHoles = 0;
+                size_t chunkFrames = 0;
+                for (int frame = 0; frame < frames; frame++) {
+                    position = position + velocity * frameTime;
+                    auto start = Clock::now();
+                    world.Update(position, nullptr);
+                    worstMs = std::max(worstMs, ElapsedMs(start));
+
+                    World::DebugStats stats = world.GetDebugStats();
+                    worstHoles = std::max(worstHoles, stats.visibleUnmeshedChunks);
+                    chunkFrames += static_cast<size_t>(stats.chunkCount);
+                }
+
+                World::DebugStats stats = world.GetDebugStats();
+                std::fprintf(out, "  %-8s prefetch %-3s  %3llu chunks visible before meshed  (at most %2zu at once)  %5.1f chunks loaded  worst %.3f ms\n",
+                             viewNames[view], enabled ? "on" : "off",
+                             static_cast<unsigned long long>(stats.chunksVisibleBeforeMeshed - lateBefore),
+                             worstHoles, static_cast<double>(chunkFrames) / frames, worstMs);
+            }
+        }
+        std::fprintf(out, "\n");
+    }
+
+    // Runs the render distance tuner against simulated machines whose frame
+    // time is the real World::Update time plus a fixed cost and a cost per
+    // drawn chunk (standing in for rendering)
+    void BenchmarkRenderDistanceTuner(std::FILE* out) {
+        struct Machine {
+            const char* name;
+            float targetFps;
+            float baseMs;
+            float chunkMs;
+        };
+        const Machine machines[3] = {
+            { "weak", 60.0f, 2.0f, 0.10f },
+            { "strong", 60.0f, 2.0f, 0.02f },
+            { "strong", 144.0f, 2.0f, 0.02f },
+        };
+        const float simulatedSeconds = 90.0f;
+        std::fprintf(out, "Render distance tuner (%.0f simulated seconds, main thread)\n", simulatedSeconds);
+
+        for (const Machine& machine : machines) {
+            World world(kBenchmarkSeed, 0);
+            RenderDistanceTuner tuner(world.GetRenderDistance(), 4, 16, machine.targetFps);
+            Vector3 position(0.0f, 100.0f, 0.0f);
+
+            float elapsed = 0.0f;
+            int changes = 0;
+            int lateFrames = 0;
+            int lateWindowFrames = 0;
+            float lastChange = 0.0f;
+            while (elapsed < simulatedSeconds) {
+                auto start = Clock::now();
+                world.Update(position, nullptr);
+                float updateMs = static_cast<float>(ElapsedMs(start));
+                float frameMs = machine.baseMs + updateMs + machine.chunkMs * world.GetDebugStats().renderedChunkCount;
+                elapsed += frameMs / 1000.0f;
+
+                float loadMs = 0.0f;
+                for (double stageMs : world.GetLoadStats().lastFrameMs) {
+                    loadMs += static_cast<float>(stageMs);
+                }
+                if (tuner.Update(frameMs / 1000.0f, loadMs, world.HasPendingWork())) {
+                    world.SetRenderDistance(tuner.GetDistance());
+                    changes++;
+                    lastChange = elapsed;
+                }
+
+                // Frame rate over the last third of the run
+                if (elapsed > simulatedSeconds * 2.0f / 3.0f) {
+                    lateWindowFrames++;
+                    if (frameMs > tuner.GetTargetMs()) lateFrames++;
+                }
+            }
+
+            World::DebugStats stats = world.GetDebugStats();
+            std::fprintf(out, "  %-6s @ %3.0f fps  distance %2d (%s)  %3d chunks drawn  %.1f ms/frame  %d changes, last at %.0f s  %.1f%% of late frames over target\n",
+                         machine.name, machine.targetFps, tuner.GetDistance(), tuner.GetReasonText(), stats.renderedChunkCount,
+                         tuner.GetSmoothedFrameMs(), changes, lastChange,
+                         lateWindowFrames > 0 ? 100.0 * lateFrames / lateWindowFrames : 0.0);
+        }
+        std::fprintf(out, "\n");
+    }
+
+    // Loads the full render distance from scratch with different worker
+    // thread counts; every count must produce the same meshes as 0 (all on
+    // the calling thread)
+    void BenchmarkWorkerThreads(std::FILE* out) {
+        int maxThreads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+        std::fprintf(out, "Worker threads (full load, %d hardware threads)\n", maxThreads);
+
+        double inlineRate = 0.0;
+        uint64_t inlineFingerprint = 0;
+        for (int threads = 0; threads <= maxThreads; threads = threads == 0 ? 1 : threads * 2) {
+            World world(kBenchmarkSeed, threads);
+            world.SetLoadBudget({ 0.0, 0.0, 0.0 });
+            Vector3 position(0.0f, 100.0f, 0.0f);
+
+            auto start = Clock::now();
+            LoadAround(world, position);
+            double ms = ElapsedMs(start);
+
+            World::DebugStats stats = world.GetDebugStats();
+            uint64_t fingerprint = 0;
+            for (int cx = -16; cx <= 16; cx++) {
+                for (int cz = -16; cz <= 16; cz++) {
+                    const Chunk* chunk = world.FindChunk(cx, cz);
+                    if (chunk) {
+                        fingerprint = fingerprint * 1099511628211ull + MeshFingerprint(SolidVertices(*chunk));
+                        fingerprint = fingerprint * 1099511628211ull + MeshFingerprint(TransparentVertices(*chunk));
+                    }
+                }
+            }
+
+            double rate = stats.chunkCount / (ms / 1000.0);
+            if (threads == 0) {
+                inlineRate = rate;
+                inlineFingerprint = fingerprint;
+            }
+            std::fprintf(out, "  %2d threads  %d chunks in %7.1f ms  %6.1f chunks/s  (%.2fx)  [fingerprint %016llx %s]\n",
+                         threads, stats.chunkCount, ms, rate, rate / inlineRate,
+                         static_cast<unsigned long long>(fingerprint),
+                         fingerprint == inlineFingerprint ? "same" : "DIFFERENT");
+        }
+        std::fprintf(out, "\n");
+    }
+
+    // Cold start as the game does it: spawn chunk and ring first (when the
+    // first frame can be shown), then the rest of the render distance
+    void BenchmarkStartup(std::FILE* out) {
+        const int spawnRingRadius = 1;
+        std::fprintf(out, "Startup (default budget, spawn ring radius %d)\n", spawnRingRadius);
+
+        int workerCounts[] = { 0, -1 };
+        for (int workers : workerCounts) {
+            auto start = Clock::now();
+            World world(kBenchmarkSeed, workers);
+            Vector3 spawn(0.0f, 100.0f, 0.0f);
+
+            double firstFrameMs = 0.0;
+            int firstFrameUpdates = 0;
+            int updates = 0;
+            do {
+                world.Update(spawn, nullptr);
+                updates++;
+                if (!firstFrameUpdates && world.IsAreaReady(spawn, spawnRingRadius, false)) {
+                    firstFrameMs = ElapsedMs(start);
+                    firstFrameUpdates = updates;
+                }
+                std::this_thread::yield();
+            } while (world.HasPendingWork());
+            double fullMs = ElapsedMs(start);
+
+            World::DebugStats stats = world.GetDebugStats();
+            std::fprintf(out, "  %-8s  first frame %7.1f ms (%3d updates)  full radius %7.1f ms (%4d updates, %d chunks)\n",
+                         workers == 0 ? "inline" : "workers", firstFrameMs, firstFrameUpdates,
+                         fullMs, updates, stats.chunkCount);
+        }
+        std::fprintf(out, "\n");
+    }
+
+    // Several observers over one world: overlapping ticket areas are loaded
+    // once, and an observer's chunks go when its ticket does
+    void BenchmarkObservers(std::FILE* out) {
+        std::fprintf(out, "Observers (render distance 8, observer radius 8)\n");
+
+        struct Scenario {
+            const char* name;
+            int offsetChunks; // Observer distance from the player; < 0 for none
+        };
+        const Scenario scenarios[] = {
+            { "player only", -1 },
+            { "overlapping (4 chunks apart)", 4 },
+            { "disjoint (64 chunks apart)", 64 },
+        };
+
+        for (const Scenario& scenario : scenarios) {
+            World world(kBenchmarkSeed, 0);
+            world.SetLoadBudget({ 0.0, 0.0, 0.0 });
+            Vector3 position(0.0f, 100.0f, 0.0f);
+
+            World::ObserverId observer = 0;
+            if (scenario.offsetChunks >= 0) {
+                observer = world.AddObserver(Vector3(scenario.offsetChunks * static_cast<float>(CHUNK_SIZE), 100.0f, 0.0f), 8);
+            }
+
+            auto start = Clock::now();
+            LoadAround(world, position);
+            double ms = ElapsedMs(start);
+            World::DebugStats stats = world.GetDebugStats();
+            uint64_t loads = stats.scheduler.completed[ChunkScheduler::Generate];
+            std::fprintf(out, "  %-30s %4d chunks loaded (%4llu loads, %zu in grid overflow) in %7.1f ms",
+                         scenario.name, stats.chunkCount, static_cast<unsigned long long>(loads),
+                         stats.chunkGridOverflow, ms);
+
+            if (scenario.offsetChunks >= 0) {
+                world.RemoveObserver(observer);
+                LoadAround(world, position);
+                std::fprintf(out, "  -> %d after removing the observer", world.GetDebugStats().chunkCount);
+            }
+            std::fprintf(out, "\n");
+        }
+        std::fprintf(out, "\n");
+    }
+
+    // Edits queued from several threads at once, applied by one Update and
+    // delivered to a subscriber as a single batch
+    void BenchmarkEditQueue(std::FILE* out) {
+        const int threadCount = 4;
+        const int editsPerThread = 16384; // A 32x32 column of 16 layers each
+        std::fprintf(out, "Edit queue (%d threads x %d edits)\n", threadCount, editsPerThread);
+
+        World world(kBenchmarkSeed, 0);
+        world.SetLoadBudget({ 0.0, 0.0, 0.0 });
+        Vector3 position(0.0f, 100.0f, 0.0f);
+        LoadAround(world, position);
+
+        size_t batches = 0;
+        size_t changes = 0;
+        world.SubscribeToChanges([&](const std::vector<BlockChange>& batch) {
+            batches++;
+            changes += batch.size();
+        });
+
+        for (int round = 0; round < 2; round++) {
+            auto start = Clock::now();
+            std::vector<std::thread> threads;
+            for (int t = 0; t < threadCount; t++) {
+                threads.emplace_back([&world, t, editsPerThread]() {
+                    for (int i = 0; i < editsPerThread; i++) {
+                        int x = t * 32 + (i & 31) - 64;
+                        int z = ((i >> 5) & 31) - 16;
+                        int y = 200 + (i >> 10);
+                        world.QueueSetBlock(x, y, z, BlockType::Stone);
+                    }
+                });
+            }
+            for (std::thread& thread : threads) {
+                thread.join();
+            }
+            double queueMs = ElapsedMs(start);
+
+            batches = 0;
+            changes = 0;
+            start = Clock::now();
+            world.Update(position, nullptr);
+            double applyMs = ElapsedMs(start);
+
+            // The second round sets the same blocks again: nothing changes
+            std::fprintf(out, "  %s  queue %6.2f ms (%4.0f ns/edit)  Update %6.2f ms  %zu changes in %zu batches\n",
+                         round == 0 ? "new blocks " : "same blocks", queueMs,
+                         queueMs * 1.0e6 / (threadCount * editsPerThread), applyMs, changes, batches);
+        }
+        std::fprintf(out, "\n");
+    }
+
+    // Reader threads looking up blocks around the player while the main
+    // thread flies, edits and unloads; compares the main thread's update
+    // time with and without readers
+    void BenchmarkConcurrentReads(std::FILE* out) {
+        const float flySpeed = 20.0f;
+        const float frameTime = 1.0f / 60.0f;
+        const int frames = 300;
+        std::fprintf(out, "Concurrent reads (flight at %.0f blocks/s for %d frames, edits every frame)\n", flySpeed, frames);
+
+        const int readerCounts[] = { 0, 2 };
+        for (int readers : readerCounts) {
+            World world(kBenchmarkSeed, 0);
+            Vector3 position(0.0f, 100.0f, 0.0f);
+            LoadAround(world, position);
+
+            std::atomic<bool> stop(false);
+            std::atomic<int> centerX(0);
+            std::atomic<uint64_t> reads(0);
+            std::atomic<uint64_t> solid(0);
+            std::vector<std::thread> threads;
+            for (int t = 0; t < readers; t++) {
+                threads.emplace_back([&, t]() {
+                    PublishedChunks::Subscription subscription(world.GetPublishedChunks());
+                    uint32_t seed = 12345u + t;
+                    while (!stop.load()) {
+                        PublishedChunks::Reader reader(world.GetPublishedChunks());
+                        uint64_t found = 0;
+                        int x0 = centerX.load();
+                        for (int i = 0; i < 4096; i++) {
+                            seed = seed * 1664525u + 1013904223u;
+                            int x = x0 + static_cast<int>(seed >> 24) - 128;
+                            int z = static_cast<int>((seed >> 16) & 0xFF) - 128;
+                            int y = static_cast<int>((seed >> 8) & 0x7F);
+                            found += reader.GetBlock(x, y, z).type != BlockType::Air ? 1 : 0;
+                        }
+                        reads += 4096;
+                        solid += found;
+                    }
+                });
+            }
+
+            double totalMs = 0.0;
+            double worstMs = 0.0;
+            size_t mostRetired = 0;
+            double publishMsBefore = world.GetDebugStats().published.publishMs;
+            auto start = Clock::now();
+            for (int frame = 0; frame < frames; frame++) {
+                position.x += flySpeed * frameTime;
+                centerX.store(static_cast<int>(position.x));
+                world.SetBlock(static_cast<int>(position.x), 120, 0, frame & 1 ? BlockType::Stone : BlockType::Air);
+                auto updateStart = Clock::now();
+                world.Update(position, nullptr);
+                double ms = ElapsedMs(updateStart);
+                totalMs += ms;
+                worstMs = std::max(worstMs, ms);
+                mostRetired = std::max(mostRetired, world.GetDebugStats().published.retiredCount);
+            }
+            double seconds = ElapsedMs(start) / 1000.0;
+            stop.store(true);
+            for (std::thread& thread : threads) {
+                thread.join();
+            }
+
+            World::DebugStats stats = world.GetDebugStats();
+            std::fprintf(out, "  %d readers  World::Update avg %.3f ms  worst %.3f ms  publish avg %.4f ms  %6.1f M reads/s  %llu publishes  %llu copies  %llu bucket copies  at most %zu retired\n",
+                         readers, totalMs / frames, worstMs, (stats.published.publishMs - publishMsBefore) / frames, reads.load() / seconds / 1.0e6,
+                         static_cast<unsigned long long>(stats.published.publishes),
+                         static_cast<unsigned long long>(stats.published.copies),
+                         static_cast<unsigned long long>(stats.published.bucketCopies), mostRetired);
+        }
+        std::fprintf(out, "\n");
+    }
+
+    // Bulk edits against the same edits made one SetBlock at a time; both
+    // worlds must end up with the same blocks, states, heights and meshes
+    void BenchmarkBulkEdits(std::FILE* out) {
+        std::fprintf(out, "Bulk edits (bulk API vs SetBlock per block)\n");
+
+        World bulk(kBenchmarkSeed, 0);
+        World single(kBenchmarkSeed, 0);
+        bulk.SetLoadBudget({ 0.0, 0.0, 0.0 });
+        single.SetLoadBudget({ 0.0, 0.0, 0.0 });
+        Vector3 position(0.0f, 100.0f, 0.0f);
+        LoadAround(bulk, position);
+        LoadAround(single, position);
+
+        BlockBuffer prefab(40, 40, 40);
+        for (int x = 0; x < prefab.sizeX; x++) {
+            for (int y = 0; y < prefab.sizeY; y++) {
+                for (int z = 0; z < prefab.sizeZ; z++) {
+                    if (x == 0 || y == 0 || z == 0 || (x + y + z) % 7 == 0) {
+                        prefab.Set(x, y, z, (x + z) & 1 ? BlockType::Wood : BlockType::Leaves);
+                    }
+                }
+            }
+        }
+
+        const int sphereRadius = 62; // About a million blocks
+        struct Operation {
+            const char* name;
+            size_t blocks;
+            std::function<void(World&)> bulk;
+            std::function<void(World&)> single;
+            // Untimed setup, made in both worlds first
+            std::function<void(World&)> prepare;
+            // Changes no block, so no chunk may be remeshed
+            bool unchanged = false;
+        };
+        // Stateful water in a box, some of it filled over with water again:
+        // those blocks keep their state, the rest lose it
+        auto placeWater = [](World& world) {
+            for (int x = 60; x < 92; x++)
+                for (int y = 150; y < 182; y++)
+                    for (int z = 60; z < 92; z++) {
+                        world.SetBlock(x, y, z, BlockType::Water);
+                        if ((x + y + z) % 3 == 0) world.SetBlockState(x, y, z, static_cast<BlockState>(1 + (x + z) % 7));
+                    }
+        };
+        const Operation operations[] = {
+            { "fill 100^3 box", 1000000,
+              [](World& world) { world.FillBox(-50, 100, -50, 49, 199, 49, BlockType::Stone); },
+              [](World& world) {
+                  for (int x = -50; x <= 49; x++)
+                      for (int y = 100; y <= 199; y++)
+                          for (int z = -50; z <= 49; z++) world.SetBlock(x, y, z, BlockType::Stone);
+              } },
+            { "replace in 120^3 box", 1728000,
+              [](World& world) { world.ReplaceInBox(-60, 40, -60, 59, 159, 59, BlockType::Stone, BlockType::Dirt); },
+              [](World& world) {
+                  for (int x = -60; x <= 59; x++)
+                      for (int y = 40; y <= 159; y++)
+                          for (int z = -60; z <= 59; z++)
+                              if (world.GetBlock(x, y, z).type == BlockType::Stone) world.SetBlock(x, y, z, BlockType::Dirt);
+              } },
+            { "sphere r=62", 998647,
+              [=](World& world) { world.FillSphere(10, 128, -5, sphereRadius, BlockType::Air); },
+              [=](World& world) {
+                  for (int x = -sphereRadius; x <= sphereRadius; x++)
+                      for (int y = -sphereRadius; y <= sphereRadius; y++)
+                          for (int z = -sphereRadius; z <= sphereRadius; z++)
+                              if (x * x + y * y + z * z <= sphereRadius * sphereRadius) world.SetBlock(10 + x, 128 + y, -5 + z, BlockType::Air);
+              } },
+            { "paste 40^3 prefab", 64000,
+              [&](World& world) { world.Paste(prefab, -20, 110, -20, true); },
+              [&](World& world) {
+                  for (int x = 0; x < prefab.sizeX; x++)
+                      for (int y = 0; y < prefab.sizeY; y++)
+                          for (int z = 0; z < prefab.sizeZ; z++)
+                              if (prefab.Get(x, y, z) != BlockType::Air) world.SetBlock(x - 20, y + 110, z - 20, prefab.Get(x, y, z));
+              } },
+            { "fill over states", 32768,
+              [](World& world) { world.FillBox(64, 150, 64, 95, 181, 95, BlockType::Water); },
+              [](World& world) {
+                  for (int x = 64; x <= 95; x++)
+                      for (int y = 150; y <= 181; y++)
+                          for (int z = 64; z <= 95; z++) world.SetBlock(x, y, z, BlockType::Water);
+              },
+              placeWater },
+            { "refill filled box", 32768,
+              [](World& world) { world.FillBox(64, 150, 64, 95, 181, 95, BlockType::Water); },
+              [](World& world) {
+                  for (int x = 64; x <= 95; x++)
+                      for (int y = 150; y <= 181; y++)
+                          for (int z = 64; z <= 95; z++) world.SetBlock(x, y, z, BlockType::Water);
+              },
+              nullptr, true },
+        };
+
+        for (const Operation& operation : operations) {
+            if (operation.prepare) {
+                operation.prepare(bulk);
+                operation.prepare(single);
+                LoadAround(bulk, position);
+                LoadAround(single, position);
+            }
+            uint64_t meshesBefore = bulk.GetLoadStats().completed[ChunkScheduler::Mesh];
+            auto start = Clock::now();
+            operation.bulk(bulk);
+            double bulkMs = ElapsedMs(start);
+            LoadAround(bulk, position);
+            uint64_t remeshes = bulk.GetLoadStats().completed[ChunkScheduler::Mesh] - meshesBefore;
+
+            start = Clock::now();
+            operation.single(single);
+            double singleMs = ElapsedMs(start);
+            LoadAround(single, position);
+
+            std::fprintf(out, "  %-22s %8zu blocks  bulk %8.2f ms  SetBlock %9.2f ms  (%5.1fx)  %3llu chunk remeshes%s\n",
+                         operation.name, operation.blocks, bulkMs, singleMs, singleMs / bulkMs,
+                         static_cast<unsigned long long>(remeshes),
+                         !operation.unchanged ? "" : remeshes == 0 ? "  (none expected)" : "  UNEXPECTED");
+        }
+
+        // Same blocks, states, heights and meshes
+        bool same = true;
+        for (int cx = -8; cx <= 8 && same; cx++) {
+            for (int cz = -8; cz <= 8 && same; cz++) {
+                const Chunk* a = bulk.FindChunk(cx, cz);
+                const Chunk* b = single.FindChunk(cx, cz);
+                if (!a || !b) {
+                    same = a == b;
+                    continue;
+                }
+                same = MeshFingerprint(SolidVertices(*a)) == MeshFingerprint(SolidVertices(*b)) &&
+                       MeshFingerprint(TransparentVertices(*a)) == MeshFingerprint(TransparentVertices(*b)) &&
+                       a->GetMinY() == b->GetMinY() && a->GetMaxY() == b->GetMaxY();
+                for (int x = 0; x < CHUNK_SIZE && same; x++) {
+                    for (int z = 0; z < CHUNK_SIZE && same; z++) {
+                        same = a->GetHeight(x, z) == b->GetHeight(x, z);
+                        for (int y = 0; y < CHUNK_HEIGHT && same; y++) {
+                            same = a->GetBlockType(x, y, z) == b->GetBlockType(x, y, z) &&
+                                   a->GetBlockState(x, y, z) == b->GetBlockState(x, y, z);
+                        }
+                    }
+                }
+            }
+        }
+        std::fprintf(out, "  result %s\n\n", same ? "same as SetBlock" : "DIFFERENT from SetBlock");
+    }
+
+    // World::FindNearest and ForEachOfType against walking every block in
+    // range through World::GetBlock
+    void BenchmarkSpatialQueries(std::FILE* out) {
+        std::fprintf(out, "Spatial queries (radius 48, per-section type masks vs GetBlock scan)\n");
+
+        World world(kBenchmarkSeed, 0);
+        world.SetLoadBudget({ 0.0, 0.0, 0.0 });
+        Vector3 position(0.0f, 100.0f, 0.0f);
+        LoadAround(world, position);
+
+        // A few torches, as a rare type
+        uint32_t rng = 29;
+        auto next = [&rng](int range) {
+            rng = rng * 1664525u + 1013904223u;
+            return static_cast<int>((rng >> 8) % static_cast<uint32_t>(range));
+        };
+        for (int i = 0; i < 24; i++) {
+            world.SetBlock(next(192) - 96, 60 + next(40), next(192) - 96, BlockType::Torch);
+        }
+
+        const int radius = 48;
+        const int queryCount = 16;
+        struct Query {
+            int x, y, z;
+        };
+        std::vector<Query> queries;
+        for (int i = 0; i < queryCount; i++) {
+            queries.push_back({ next(96) - 48, 50 + next(60), next(96) - 48 });
+        }
+
+        const BlockType types[] = { BlockType::Water, BlockType::Wood, BlockType::Torch, BlockType::Stone };
+        const char* names[] = { "water", "wood", "torch", "stone" };
+        for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+            BlockType type = types[t];
+
+            // Nearest distance and count per query, both ways
+            std::vector<int> nearest(queryCount), scanNearest(queryCount);
+            std::vector<size_t> counts(queryCount), scanCounts(queryCount);
+
+            auto start = Clock::now();
+            for (int i = 0; i < queryCount; i++) {
+                const Query& q = queries[i];
+                int x, y, z;
+                nearest[i] = world.FindNearest(type, q.x, q.y, q.z, radius, x, y, z)
+                    ? (x - q.x) * (x - q.x) + (y - q.y) * (y - q.y) + (z - q.z) * (z - q.z) : -1;
+            }
+            double nearestMs = ElapsedMs(start);
+
+            start = Clock::now();
+            for (int i = 0; i < queryCount; i++) {
+                const Query& q = queries[i];
+                world.ForEachOfType(type, q.x, q.y, q.z, radius, [&](int, int, int) { counts[i]++; });
+            }
+            double forEachMs = ElapsedMs(start);
+
+            start = Clock::now();
+            for (int i = 0; i < queryCount; i++) {
+                const Query& q = queries[i];
+                scanNearest[i] = -1;
+                scanCounts[i] = 0;
+                for (int dx = -radius; dx <= radius; dx++) {
+                    for (int dy = -radius; dy <= radius; dy++) {
+                        for (int dz = -radius; dz <= radius; dz++) {
+                            int distanceSq = dx * dx + dy * dy + dz * dz;
+                            if (distanceSq > radius * radius ||
+                                world.GetBlock(q.x + dx, q.y + dy, q.z + dz).type != type) {
+                                continue;
+                            }
+                            scanCounts[i]++;
+                            if (scanNearest[i] < 0 || distanceSq < scanNearest[i]) {
+                                scanNearest[i] = distanceSq;
+                            }
+                        }
+                    }
+                }
+            }
+            double scanMs = ElapsedMs(start);
+
+            size_t found = 0;
+            for (size_t count : counts) {
+                found += count;
+            }
+            bool same = nearest == scanNearest && counts == scanCounts;
+            std::fprintf(out, "  %-6s FindNearest %8.3f ms/query  ForEachOfType %8.3f ms/query  scan %8.2f ms/query  "
+                         "(%6.0fx, %5.1fx)  %8zu found  %s\n",
+                         names[t], nearestMs / queryCount, forEachMs / queryCount, scanMs / queryCount,
+                         scanMs / nearestMs, scanMs / forEachMs, found, same ? "same" : "DIFFERENT");
+        }
+        std::fprintf(out, "\n");
+    }
+
+    void BenchmarkMeshing(std::FILE* out, const std::vector<std::unique_ptr<Chunk>>& chunks) {
+        const int iterations = 10; // a bitmask pass over the chunks takes a few ms
+
+        // Greedy first, so the chunks are left with per-face meshes. Each
+        // mode meshes every chunk once untimed, so all three are timed
+        // remeshing into the capacity a chunk keeps between meshes.
+        uint64_t greedySolidIndices = 0;
+        uint64_t greedyTransparentIndices = 0;
+        uint64_t greedyFingerprint = 0;
+        for (const auto& chunk : chunks) chunk->GenerateMesh(MeshMode::Greedy);
+        auto start = Clock::now();
+        for (int i = 0; i < iterations; i++) {
+            greedySolidIndices = 0;
+            greedyTransparentIndices = 0;
+            for (const auto& chunk : chunks) {
+                chunk->GenerateMesh(MeshMode::Greedy);
+                greedySolidIndices += chunk->GetSolidQuads().size() * 6;
+                greedyTransparentIndices += chunk->GetTransparentQuads().size() * 6;
+            }
+        }
+        double greedyMs = ElapsedMs(start) / (iterations * chunks.size());
+        for (const auto& chunk : chunks) {
+            greedyFingerprint += UnitFaceFingerprint(SolidVertices(*chunk));
+            greedyFingerprint += UnitFaceFingerprint(TransparentVertices(*chunk));
+        }
+
+        uint64_t bitmaskSolidIndices = 0;
+        uint64_t bitmaskTransparentIndices = 0;
+        for (const auto& chunk : chunks) chunk->GenerateMesh(MeshMode::Bitmask);
+        start = Clock::now();
+        for (int i = 0; i < iterations; i++) {
+            bitmaskSolidIndices = 0;
+            bitmaskTransparentIndices = 0;
+            for (const auto& chunk : chunks) {
+                chunk->GenerateMesh(MeshMode::Bitmask);
+                bitmaskSolidIndices += chunk->GetSolidQuads().size() * 6;
+                bitmaskTransparentIndices += chunk->GetTransparentQuads().size() * 6;
+            }
+        }
+        double bitmaskMs = ElapsedMs(start) / (iterations * chunks.size());
+        std::vector<std::vector<Vertex>> bitmaskSolid, bitmaskTransparent;
+        for (const auto& chunk : chunks) {
+            bitmaskSolid.push_back(SolidVertices(*chunk));
+            bitmaskTransparent.push_back(TransparentVertices(*chunk));
+        }
+
+        uint64_t solidIndices = 0;
+        uint64_t transparentIndices = 0;
+        uint64_t fingerprint = 0;
+
+        for (const auto& chunk : chunks) chunk->GenerateMesh();
+        start = Clock::now();
+        for (int i = 0; i < iterations; i++) {
+            solidIndices = 0;
+            transparentIndices = 0;
+            for (const auto& chunk : chunks) {
+                chunk->GenerateMesh();
+                solidIndices += chunk->GetSolidQuads().size() * 6;
+                transparentIndices += chunk->GetTransparentQuads().size() * 6;
+            }
+        }
+        double ms = ElapsedMs(start) / (iterations * chunks.size());
+        // Outside the timing, as for the other modes
+        for (const auto& chunk : chunks) {
+            fingerprint += MeshFingerprint(SolidVertices(*chunk));
+            fingerprint += MeshFingerprint(TransparentVertices(*chunk));
+        }
+
+        std::fprintf(out, "Chunk::GenerateMesh (%s layout)\n", ChunkLayout::kName);
+        std::fprintf(out, "  %.3f ms/chunk  solid idx %llu  transparent idx %llu  [fingerprint %016llx]\n",
+                     ms,
+                     static_cast<unsigned long long>(solidIndices),
+                     static_cast<unsigned long long>(transparentIndices),
+                     static_cast<unsigned long long>(fingerprint));
+        // Face finding alone, which is all the two meshers do differently
+        size_t perFaceFaces = 0;
+        size_t bitmaskFaces = 0;
+        start = Clock::now();
+        for (int i = 0; i < iterations; i++) {
+            for (const auto& chunk : chunks) perFaceFaces += chunk->CountVisibleFaces(MeshMode::PerFace);
+        }
+        double perFaceFindMs = ElapsedMs(start) / (iterations * chunks.size());
+        start = Clock::now();
+        for (int i = 0; i < iterations; i++) {
+            for (const auto& chunk : chunks) bitmaskFaces += chunk->CountVisibleFaces(MeshMode::Bitmask);
+        }
+        double bitmaskFindMs = ElapsedMs(start) / (iterations * chunks.size());
+
+        bool bitmaskSame = bitmaskSolidIndices == solidIndices && bitmaskTransparentIndices == transparentIndices &&
+                           perFaceFaces == bitmaskFaces;
+        for (size_t i = 0; i < chunks.size() && bitmaskSame; i++) {
+            bitmaskSame = SameQuads(bitmaskSolid[i], SolidVertices(*chunks[i])) &&
+                          SameQuads(bitmaskTransparent[i], TransparentVertices(*chunks[i]));
+        }
+        std::fprintf(out, "  bitmask: %.3f ms/chunk (%.1fx)  finding faces %.3f ms/chunk vs %.3f (%.1fx)  "
+                     "solid idx %llu  transparent idx %llu  quads %s\n",
+                     bitmaskMs, ms / bitmaskMs, bitmaskFindMs, perFaceFindMs, perFaceFindMs / bitmaskFindMs,
+                     static_cast<unsigned long long>(bitmaskSolidIndices),
+                     static_cast<unsigned long long>(bitmaskTransparentIndices),
+                     bitmaskSame ? "same as per-face" : "DIFFERENT from per-face");
+        // Cut back into unit faces, the greedy mesh must cover the same faces
+        std::fprintf(out, "  greedy: %.3f ms/chunk  solid idx %llu (%.1fx fewer)  transparent idx %llu (%.1fx fewer)  faces %s\n\n",
+                     greedyMs,
+                     static_cast<unsigned long long>(greedySolidIndices),
+                     static_cast<double>(solidIndices) / std::max<uint64_t>(greedySolidIndices, 1),
+                     static_cast<unsigned long long>(greedyTransparentIndices),
+                     static_cast<double>(transparentIndices) / std::max<uint64_t>(greedyTransparentIndices, 1),
+                     greedyFingerprint == fingerprint ? "same as per-face" : "DIFFERENT from per-face");
+    }
+
+    // What the renderers get from World::GatherSolidMesh (and the DXR
+    // acceleration structures are built from) in each mesh mode
+    void BenchmarkMeshModes(std::FILE* out) {
+        std::fprintf(out, "World mesh modes (render distance 8)\n");
+
+        World world(kBenchmarkSeed, 0);
+        world.SetLoadBudget({ 0.0, 0.0, 0.0 });
+        Vector3 position(0.0f, 100.0f, 0.0f);
+        LoadAround(world, position);
+
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        // The world starts in Bitmask, so each mode differs from the one
+        // before it and every row times a full remesh
+        const MeshMode modes[] = { MeshMode::PerFace, MeshMode::Bitmask, MeshMode::Greedy };
+        for (MeshMode mode : modes) {
+            auto start = Clock::now();
+            world.SetMeshMode(mode);
+            LoadAround(world, position);
+            double remeshMs = ElapsedMs(start);
+
+            world.GatherSolidMesh(vertices, indices);
+            size_t solidBytes = vertices.size() * sizeof(Vertex) + indices.size() * sizeof(uint32_t);
+            size_t solidIndices = indices.size();
+            world.GatherTransparentMesh(position, vertices, indices);
+            std::fprintf(out, "  %-8s remesh %7.1f ms  solid %8zu idx %6.1f MB  transparent %7zu idx  (DebugStats: %s)\n",
+                         GetMeshModeName(mode), remeshMs, solidIndices, solidBytes / (1024.0 * 1024.0), indices.size(),
+                         GetMeshModeName(world.GetDebugStats().meshMode));
+        }
+
+        // The drawn chunks again without their neighbors' borders, so the
+        // walls along every chunk side are meshed
+        const int distance = world.GetRenderDistance();
+        size_t chunkLocalIndices = 0;
+        Chunk snapshot(0, 0);
+        for (int chunkX = -distance; chunkX <= distance; chunkX++) {
+            for (int chunkZ = -distance; chunkZ <= distance; chunkZ++) {
+                const Chunk* chunk = world.FindChunk(chunkX, chunkZ);
+                if (!chunk || chunkX * chunkX + chunkZ * chunkZ > distance * distance) continue;
+                snapshot.CopyBlocksFrom(*chunk);
+                snapshot.GenerateMesh(MeshMode::Bitmask);
+                chunkLocalIndices += snapshot.GetSolidQuads().size() * 6;
+            }
+        }
+        world.SetMeshMode(MeshMode::Bitmask);
+        LoadAround(world, position);
+        world.GatherSolidMesh(vertices, indices);
+        std::fprintf(out, "  bitmask without neighbor borders: solid %8zu idx (%.1fx the culled %zu)\n",
+                     chunkLocalIndices, static_cast<double>(chunkLocalIndices) / indices.size(), indices.size());
+        std::fprintf(out, "\n");
+    }
+
+    // Same 128x128 block area of terrain cut into chunks of each shape
+    template <typename Shape>
+    void BenchmarkChunkShape(std::FILE* out, const char* name) {
+        const int areaSize = 128;
+        const int chunksAcross = areaSize / Shape::Size;
+        const int chunksUp = WORLD_HEIGHT / Shape::Height;
+        TerrainGenerator generator(kBenchmarkSeed);
+
+        std::vector<std::unique_ptr<BasicChunk<Shape>>> chunks;
+        auto start = Clock::now();
+        for (int cx = -chunksAcross / 2; cx < chunksAcross / 2; cx++) {
+            for (int cz = -chunksAcross / 2; cz < chunksAcross / 2; cz++) {
+                for (int cy = 0; cy < chunksUp; cy++) {
+                    auto chunk = std::make_unique<BasicChunk<Shape>>(cx, cz, cy);
+                    generator.GenerateChunk(chunk.get());
+                    chunks.push_back(std::move(chunk));
+                }
+            }
+        }
+        double generateMs = ElapsedMs(start);
+
+        start = Clock::now();
+        for (const auto& chunk : chunks) {
+            chunk->GenerateMesh();
+        }
+        double meshMs = ElapsedMs(start);
+
+        // One draw per non-empty solid or transparent mesh
+        int drawCalls = 0;
+        uint64_t indices = 0;
+        size_t blockBytes = 0;
+        size_t meshBytes = 0;
+        for (const auto& chunk : chunks) {
+            drawCalls += chunk->GetSolidQuads().empty() ? 0 : 1;
+            drawCalls += chunk->GetTransparentQuads().empty() ? 0 : 1;
+            indices += chunk->GetSolidQuads().size() * 6 + chunk->GetTransparentQuads().size() * 6;
+            blockBytes += chunk->GetBlockMemoryUsage();
+            meshBytes += chunk->GetCpuMeshMemoryUsage();
+        }
+        size_t chunkBytes = chunks.size() * sizeof(BasicChunk<Shape>);
+
+        std::fprintf(out, "  %-10s %4zu chunks  gen %7.1f ms  mesh %7.1f ms (%.3f ms/chunk)  %4d draws  %9llu idx  blocks %6.2f MB  meshes %6.2f MB  chunk objects %5.2f MB\n",
+                     name, chunks.size(), generateMs, meshMs, meshMs / chunks.size(), drawCalls,
+                     static_cast<unsigned long long>(indices),
+                     blockBytes / (1024.0 * 1024.0),
+                     meshBytes / (1024.0 * 1024.0),
+                     chunkBytes / (1024.0 * 1024.0));
+    }
+
+    void BenchmarkChunkShapes(std::FILE* out) {
+        std::fprintf(out, "Chunk shapes (128x128 blocks, full height)\n");
+        BenchmarkChunkShape<ChunkShape16>(out, "16x256x16");
+        BenchmarkChunkShape<ChunkShape32>(out, "32x256x32");
+        BenchmarkChunkShape<ChunkShapeCubic32>(out, "32x32x32");
+        std::fprintf(out, "\n");
+    }
+}
+
+bool RunBenchmarks(const char* outputPath) {
+    std::FILE* out = std::fopen(outputPath, "w");
+    if (!out) {
+        return false;
+    }
+
+    auto start = Clock::now();
+    std::vector<std::unique_ptr<Chunk>> chunks = GenerateChunks(kBenchmarkRadius);
+    std::fprintf(out, "Generated %zu chunks in %.1f ms\n\n", chunks.size(), ElapsedMs(start));
+
+    BenchmarkBlockStorage(out, chunks);
+    BenchmarkMeshing(out, chunks);
+    BenchmarkLayouts(out, chunks);
+    BenchmarkRaycast(out);
+    BenchmarkChunkLookup(out);
+    BenchmarkFlight(out);
+    BenchmarkBorderCrossing(out);
+    BenchmarkMemoryBudget(out);
+    BenchmarkPrefetch(out);
+    BenchmarkRenderDistanceTuner(out);
+    BenchmarkWorkerThreads(out);
+    BenchmarkStartup(out);
+    BenchmarkObservers(out);
+    BenchmarkEditQueue(out);
+    BenchmarkConcurrentReads(out);
+    BenchmarkBulkEdits(out);
+    BenchmarkSpatialQueries(out);
+    BenchmarkMeshModes(out);
+
+    // Free the default-shape chunks so shared section storage is not split with them
+    chunks.clear();
+    BenchmarkChunkShapes(out);
+
+    std::fclose(out);
+    return true;
+}
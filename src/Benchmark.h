@@ -0,0 +1,5 @@
+#pragma once
+
+// Runs the offline world benchmarks (no window or GPU needed) and writes
+// the report to outputPath. Started with "RTXBlocks.exe --benchmark".
+bool RunBenchmarks(const char* outputPath);
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
 
 enum class BlockType : uint8_t {
@@ -12,6 +13,37 @@ enum class BlockType : uint8_t {
     Count
 };
 
+// Per-type behaviour flags, packed so hot loops test a type with one table load
+struct BlockFlag {
+    enum : uint8_t {
+        Opaque = 1 << 0,        // hides the faces of neighboring blocks
+        Transparent = 1 << 1,
+        Liquid = 1 << 2,
+        Solid = 1 << 3,         // stands on the heightmap
+        LightEmitting = 1 << 4,
+        HasState = 1 << 5       // keeps BlockState in the section side table
+    };
+};
+
+constexpr uint8_t kBlockFlags[static_cast<size_t>(BlockType::Count)] = {
+    /* Air    */ BlockFlag::Transparent,
+    /* Dirt   */ BlockFlag::Opaque | BlockFlag::Solid,
+    /* Stone  */ BlockFlag::Opaque | BlockFlag::Solid,
+    /* Wood   */ BlockFlag::Opaque | BlockFlag::Solid,
+    /* Leaves */ BlockFlag::Transparent | BlockFlag::Solid | BlockFlag::HasState,
+    /* Water  */ BlockFlag::Transparent | BlockFlag::Liquid | BlockFlag::HasState,
+    /* Torch  */ BlockFlag::Transparent | BlockFlag::LightEmitting | BlockFlag::HasState,
+};
+static_assert(static_cast<size_t>(BlockType::Count) == 7, "new block types need a kBlockFlags entry");
+
+constexpr uint8_t GetBlockFlags(BlockType type) {
+    return kBlockFlags[static_cast<size_t>(type)];
+}
+
+// Extra per-block data (water level, torch facing, ...) for block types that
+// declare it in BlockDatabase. 0 is the default state and is never stored.
+using BlockState = uint8_t;
+
 struct BlockFace {
     enum Face : uint8_t {
         Front = 0,
@@ -30,7 +62,7 @@ struct Block {
     explicit Block(BlockType t) : type(t) {}
 
     bool IsAir() const { return type == BlockType::Air; }
-    bool IsTransparent() const { return type == BlockType::Air || type == BlockType::Water || type == BlockType::Leaves || type == BlockType::Torch; }
-    bool IsLiquid() const { return type == BlockType::Water; }
-    bool IsLightSource() const { return type == BlockType::Torch; }
+    bool IsTransparent() const { return (GetBlockFlags(type) & BlockFlag::Transparent) != 0; }
+    bool IsLiquid() const { return (GetBlockFlags(type) & BlockFlag::Liquid) != 0; }
+    bool IsLightSource() const { return (GetBlockFlags(type) & BlockFlag::LightEmitting) != 0; }
 };
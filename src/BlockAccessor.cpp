@@ -0,0 +1,69 @@
+#include "BlockAccessor.h"
+
+template <typename ChunkT>
+BlockBox BasicBlockAccessor<ChunkT>::GetBounds() const {
+    return {
+        m_originChunkX * ChunkT::Size, 0, m_originChunkZ * ChunkT::Size,
+        (m_originChunkX + 3) * ChunkT::Size - 1, ChunkT::Height - 1, (m_originChunkZ + 3) * ChunkT::Size - 1
+    };
+}
+
+template <typename ChunkT>
+void BasicBlockAccessor<ChunkT>::Read(const BlockBox& box, std::vector<BlockType>& out) const {
+    out.assign(box.GetVolume(), BlockType::Air);
+    const int sizeY = box.GetSizeY();
+    const int sizeZ = box.GetSizeZ();
+    int minY = std::max(box.minY, 0);
+    int maxY = std::min(box.maxY, ChunkT::Height - 1);
+
+    for (int cx = 0; cx < 3; cx++) {
+        int chunkMinX = (m_originChunkX + cx) * ChunkT::Size;
+        int minX = std::max(box.minX, chunkMinX);
+        int maxX = std::min(box.maxX, chunkMinX + ChunkT::Size - 1);
+        for (int cz = 0; cz < 3; cz++) {
+            const ChunkT* chunk = m_chunks[cx][cz];
+            if (!chunk) continue;
+
+            int chunkMinZ = (m_originChunkZ + cz) * ChunkT::Size;
+            int minZ = std::max(box.minZ, chunkMinZ);
+            int maxZ = std::min(box.maxZ, chunkMinZ + ChunkT::Size - 1);
+            // Rows outside the chunk's occupied range stay air
+            int rowMinY = std::max(minY, chunk->GetMinY());
+            int rowMaxY = std::min(maxY, chunk->GetMaxY());
+
+            for (int x = minX; x <= maxX; x++) {
+                for (int y = rowMinY; y <= rowMaxY; y++) {
+                    BlockType* row = out.data() + (static_cast<size_t>(x - box.minX) * sizeY + (y - box.minY)) * sizeZ;
+                    for (int z = minZ; z <= maxZ; z++) {
+                        row[z - box.minZ] = chunk->GetBlockType(x - chunkMinX, y, z - chunkMinZ);
+                    }
+                }
+            }
+        }
+    }
+}
+
+template <typename ChunkT>
+int BasicBlockAccessor<ChunkT>::FindTopOpaque(int worldX, int worldZ, int minY, int maxY) const {
+    int cx = (worldX >> ChunkT::SizeShift) - m_originChunkX;
+    int cz = (worldZ >> ChunkT::SizeShift) - m_originChunkZ;
+    const ChunkT* chunk = static_cast<unsigned>(cx) < 3 && static_cast<unsigned>(cz) < 3 ? m_chunks[cx][cz] : nullptr;
+    if (!chunk) {
+        return minY - 1;
+    }
+
+    // Nothing but air lies outside the chunk's occupied range
+    int localX = worldX & ChunkT::SizeMask;
+    int localZ = worldZ & ChunkT::SizeMask;
+    for (int y = std::min(maxY, chunk->GetMaxY()); y >= std::max(minY, chunk->GetMinY()); y--) {
+        Block block(chunk->GetBlockType(localX, y, localZ));
+        if (!block.IsAir() && !block.IsTransparent()) {
+            return y;
+        }
+    }
+    return minY - 1;
+}
+
+template class BasicBlockAccessor<BasicChunk<ChunkShape16>>;
+template class BasicBlockAccessor<BasicChunk<ChunkShape32>>;
+template class BasicBlockAccessor<BasicChunk<ChunkShapeCubic32>>;
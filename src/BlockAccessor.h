@@ -0,0 +1,128 @@
+#pragma once
+#include "Chunk.h"
+#include <algorithm>
+#include <vector>
+
+// Inclusive box of block coordinates
+struct BlockBox {
+    int minX, minY, minZ;
+    int maxX, maxY, maxZ;
+
+    int GetSizeX() const { return maxX - minX + 1; }
+    int GetSizeY() const { return maxY - minY + 1; }
+    int GetSizeZ() const { return maxZ - minZ + 1; }
+    size_t GetVolume() const {
+        return static_cast<size_t>(GetSizeX()) * GetSizeY() * GetSizeZ();
+    }
+};
+
+// Read-only view of the 3x3 chunks around a center chunk. The chunk
+// pointers are looked up once, so reads cost a shift, a mask and an array
+// load instead of a World::GetBlock. X and Z are world coordinates, Y is
+// relative to the bottom of the pinned chunks (world Y for column chunks).
+// Blocks outside the neighborhood, the chunk height or a pinned chunk read
+// as air. Reads see later writes to the pinned chunks, but a view over
+// World chunks is only valid until the next World::Update, which may
+// unload them.
+template <typename ChunkT>
+class BasicBlockAccessor {
+public:
+    // find(chunkX, chunkZ) returns the chunk at those coordinates or null
+    template <typename Find>
+    BasicBlockAccessor(int centerChunkX, int centerChunkZ, Find&& find)
+        : m_originChunkX(centerChunkX - 1)
+        , m_originChunkZ(centerChunkZ - 1) {
+        for (int cx = 0; cx < 3; cx++) {
+            for (int cz = 0; cz < 3; cz++) {
+                m_chunks[cx][cz] = find(m_originChunkX + cx, m_originChunkZ + cz);
+            }
+        }
+    }
+    // Just the one chunk, as during generation when no neighbor exists yet
+    explicit BasicBlockAccessor(const ChunkT& chunk)
+        : BasicBlockAccessor(chunk.GetChunkX(), chunk.GetChunkZ(), [&chunk](int chunkX, int chunkZ) {
+              return chunkX == chunk.GetChunkX() && chunkZ == chunk.GetChunkZ() ? &chunk : nullptr;
+          }) {
+    }
+
+    BlockType Get(int worldX, int y, int worldZ) const {
+        int cx = (worldX >> ChunkT::SizeShift) - m_originChunkX;
+        int cz = (worldZ >> ChunkT::SizeShift) - m_originChunkZ;
+        if (static_cast<unsigned>(cx) >= 3 || static_cast<unsigned>(cz) >= 3 ||
+            static_cast<unsigned>(y) >= static_cast<unsigned>(ChunkT::Height)) {
+            return BlockType::Air;
+        }
+        const ChunkT* chunk = m_chunks[cx][cz];
+        return chunk ? chunk->GetBlockType(worldX & ChunkT::SizeMask, y, worldZ & ChunkT::SizeMask)
+                     : BlockType::Air;
+    }
+
+    // Pinned chunk at an offset of -1..1 from the center, or null
+    const ChunkT* GetChunk(int dx, int dz) const { return m_chunks[dx + 1][dz + 1]; }
+    // Box covered by the neighborhood over the full chunk height
+    BlockBox GetBounds() const;
+
+    // Copies a box into out, x-major then y then z:
+    // out[((x - minX) * sizeY + (y - minY)) * sizeZ + (z - minZ)]
+    void Read(const BlockBox& box, std::vector<BlockType>& out) const;
+
+    // Highest y in minY..maxY of the column whose block is opaque and not
+    // air, or minY - 1 if there is none
+    int FindTopOpaque(int worldX, int worldZ, int minY, int maxY) const;
+
+    // fn(worldX, y, worldZ, type) for every block of the box inside the
+    // neighborhood, walked chunk by chunk with no per-block lookup
+    template <typename Fn>
+    void ForEach(const BlockBox& box, Fn&& fn) const {
+        int minY = std::max(box.minY, 0);
+        int maxY = std::min(box.maxY, ChunkT::Height - 1);
+        for (int cx = 0; cx < 3; cx++) {
+            int chunkMinX = (m_originChunkX + cx) * ChunkT::Size;
+            int minX = std::max(box.minX, chunkMinX);
+            int maxX = std::min(box.maxX, chunkMinX + ChunkT::Size - 1);
+            for (int cz = 0; cz < 3; cz++) {
+                int chunkMinZ = (m_originChunkZ + cz) * ChunkT::Size;
+                int minZ = std::max(box.minZ, chunkMinZ);
+                int maxZ = std::min(box.maxZ, chunkMinZ + ChunkT::Size - 1);
+                const ChunkT* chunk = m_chunks[cx][cz];
+
+                for (int x = minX; x <= maxX; x++) {
+                    int localX = x - chunkMinX;
+                    for (int y = minY; y <= maxY; y++) {
+                        // One section lookup per run of z within a section,
+                        // none at all for uniform sections
+                        for (int z = minZ; z <= maxZ;) {
+                            int localZ = z - chunkMinZ;
+                            int runEnd = std::min(maxZ, z + SECTION_MASK - (localZ & SECTION_MASK));
+                            if (!chunk) {
+                                for (; z <= runEnd; z++) fn(x, y, z, BlockType::Air);
+                                continue;
+                            }
+                            const ChunkSection& section = chunk->GetSection(ChunkT::GetSectionIndex(
+                                localX >> SECTION_SHIFT, y >> SECTION_SHIFT, localZ >> SECTION_SHIFT));
+                            if (section.IsUniform()) {
+                                BlockType type = section.GetUniformType();
+                                for (; z <= runEnd; z++) fn(x, y, z, type);
+                            } else {
+                                for (; z <= runEnd; z++) {
+                                    fn(x, y, z, section.Get(localX & SECTION_MASK, y & SECTION_MASK, (z - chunkMinZ) & SECTION_MASK));
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    int m_originChunkX;
+    int m_originChunkZ;
+    const ChunkT* m_chunks[3][3];
+};
+
+extern template class BasicBlockAccessor<BasicChunk<ChunkShape16>>;
+extern template class BasicBlockAccessor<BasicChunk<ChunkShape32>>;
+extern template class BasicBlockAccessor<BasicChunk<ChunkShapeCubic32>>;
+
+using BlockAccessor = BasicBlockAccessor<Chunk>;
@@ -9,14 +9,47 @@ struct BlockProperties {
     bool isTransparent;
     bool isSolid;
     const char* name;
+    bool hasState;
+    uint8_t flags;
 };
 
+// The behaviour bools are derived from kBlockFlags so the two cannot disagree
+constexpr BlockProperties MakeBlockProperties(BlockType type, const Vector4& color, float lightEmission, const char* name) {
+    return {
+        color,
+        lightEmission,
+        (GetBlockFlags(type) & BlockFlag::Transparent) != 0,
+        (GetBlockFlags(type) & BlockFlag::Solid) != 0,
+        name,
+        (GetBlockFlags(type) & BlockFlag::HasState) != 0,
+        GetBlockFlags(type)
+    };
+}
+
+// Built at compile time, so lookups need no initialization check
 class BlockDatabase {
 public:
-    static void Initialize();
-    static const BlockProperties& GetProperties(BlockType type);
+    static constexpr const BlockProperties& GetProperties(BlockType type) {
+        return s_properties[static_cast<size_t>(type)];
+    }
+    static constexpr bool HasState(BlockType type) { return (GetBlockFlags(type) & BlockFlag::HasState) != 0; }
+    static constexpr bool IsSolid(BlockType type) { return (GetBlockFlags(type) & BlockFlag::Solid) != 0; }
 
 private:
-    static std::array<BlockProperties, static_cast<size_t>(BlockType::Count)> s_properties;
-    static bool s_initialized;
+    static constexpr std::array<BlockProperties, static_cast<size_t>(BlockType::Count)> s_properties = {{
+        // Air
+        MakeBlockProperties(BlockType::Air, Vector4(0, 0, 0, 0), 0.0f, "Air"),
+        // Dirt - brown color
+        MakeBlockProperties(BlockType::Dirt, Vector4(0.6f, 0.4f, 0.2f, 1.0f), 0.0f, "Dirt"),
+        // Stone - gray color
+        MakeBlockProperties(BlockType::Stone, Vector4(0.5f, 0.5f, 0.5f, 1.0f), 0.0f, "Stone"),
+        // Wood - brown-orange color
+        MakeBlockProperties(BlockType::Wood, Vector4(0.6f, 0.3f, 0.1f, 1.0f), 0.0f, "Wood"),
+        // Leaves - green color, state: player-placed (persistent) flag
+        MakeBlockProperties(BlockType::Leaves, Vector4(0.2f, 0.8f, 0.2f, 0.7f), 0.0f, "Leaves"),
+        // Water - blue color with transparency, state: flow level
+        MakeBlockProperties(BlockType::Water, Vector4(0.2f, 0.4f, 0.9f, 0.6f), 0.0f, "Water"),
+        // Torch - yellow/orange light source, state: attached face
+        MakeBlockProperties(BlockType::Torch, Vector4(1.0f, 0.8f, 0.3f, 1.0f), 14.0f, "Torch")
+    }};
 };
@@ -0,0 +1,53 @@
+#include "BlockEdits.h"
+#include <algorithm>
+
+void BlockEditQueue::Push(const BlockEdit& edit) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_edits.push_back(edit);
+}
+
+void BlockEditQueue::TakeAll(std::vector<BlockEdit>& edits) {
+    edits.clear();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Swapping hands the emptied vector's capacity back to the queue
+    edits.swap(m_edits);
+}
+
+size_t BlockEditQueue::GetPendingCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_edits.size();
+}
+
+BlockChangeStream::BlockChangeStream()
+    : m_nextId(1)
+    , m_published(0) {
+}
+
+BlockChangeStream::ListenerId BlockChangeStream::Subscribe(Listener listener) {
+    ListenerId id = m_nextId++;
+    m_listeners.emplace_back(id, std::move(listener));
+    return id;
+}
+
+void BlockChangeStream::Unsubscribe(ListenerId id) {
+    m_listeners.erase(std::remove_if(m_listeners.begin(), m_listeners.end(),
+        [id](const std::pair<ListenerId, Listener>& entry) { return entry.first == id; }), m_listeners.end());
+    if (m_listeners.empty()) {
+        m_pending.clear();
+    }
+}
+
+void BlockChangeStream::Publish() {
+    if (m_pending.empty()) {
+        return;
+    }
+
+    // Changes made by listeners go to m_pending for the next batch
+    m_batch.swap(m_pending);
+    m_pending.clear();
+    for (const auto& entry : m_listeners) {
+        entry.second(m_batch);
+    }
+    m_published += m_batch.size();
+    m_batch.clear();
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include "Block.h"
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// A block type to set, in world coordinates
+struct BlockEdit {
+    int x, y, z;
+    BlockType type;
+};
+
+// A block whose type changed
+struct BlockChange {
+    int x, y, z;
+    BlockType oldType;
+    BlockType newType;
+};
+
+// A box of block types to paste into the world, e.g. a copied region or a
+// prefab; x-major, then y, then z
+struct BlockBuffer {
+    int sizeX, sizeY, sizeZ;
+    std::vector<BlockType> blocks;
+
+    BlockBuffer(int x, int y, int z, BlockType fill = BlockType::Air)
+        : sizeX(x), sizeY(y), sizeZ(z), blocks(static_cast<size_t>(x) * y * z, fill) {
+    }
+
+    BlockType Get(int x, int y, int z) const { return blocks[GetIndex(x, y, z)]; }
+    void Set(int x, int y, int z, BlockType type) { blocks[GetIndex(x, y, z)] = type; }
+    size_t GetIndex(int x, int y, int z) const {
+        return (static_cast<size_t>(x) * sizeY + y) * sizeZ + z;
+    }
+};
+
+// Edits submitted from any thread, applied by the world on its own thread
+// once per update, in submission order
+class BlockEditQueue {
+public:
+    void Push(const BlockEdit& edit);
+    // Moves everything queued so far into edits (which is cleared first)
+    void TakeAll(std::vector<BlockEdit>& edits);
+    size_t GetPendingCount() const;
+
+private:
+    mutable std::mutex m_mutex;
+    std::vector<BlockEdit> m_edits;
+};
+
+// Block changes collected over an update and delivered to every subscriber
+// as one batch, so lighting, persistence or networking can work on just
+// what changed. Changes are only recorded while someone is subscribed.
+// Listeners may edit the world; those changes arrive in the next batch.
+class BlockChangeStream {
+public:
+    using Listener = std::function<void(const std::vector<BlockChange>&)>;
+    using ListenerId = uint32_t;
+
+    BlockChangeStream();
+
+    // Neither may be called from inside a listener
+    ListenerId Subscribe(Listener listener);
+    void Unsubscribe(ListenerId id);
+
+    void Record(const BlockChange& change) {
+        if (!m_listeners.empty()) {
+            m_pending.push_back(change);
+        }
+    }
+    // Delivers the changes recorded since the last call, if any
+    void Publish();
+
+    size_t GetListenerCount() const { return m_listeners.size(); }
+    uint64_t GetPublishedCount() const { return m_published; }
+
+private:
+    std::vector<std::pair<ListenerId, Listener>> m_listeners;
+    ListenerId m_nextId;
+    std::vector<BlockChange> m_pending;
+    // The batch being delivered; kept to reuse its allocation
+    std::vector<BlockChange> m_batch;
+    uint64_t m_published;
+};
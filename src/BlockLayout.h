@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+
+// Compile-time storage orders for the 16x16x16 blocks of a chunk section.
+// Each policy maps section-local coordinates to a 12-bit storage index.
+
+// x slowest, z fastest: the original m_blocks[x][y][z] order
+struct XMajorLayout {
+    static constexpr const char* kName = "x-major";
+    static size_t Index(int x, int y, int z) {
+        return (static_cast<size_t>(x) << 8) | (static_cast<size_t>(y) << 4) | static_cast<size_t>(z);
+    }
+};
+
+// y fastest, so every vertical column is contiguous
+struct ColumnLayout {
+    static constexpr const char* kName = "column";
+    static size_t Index(int x, int y, int z) {
+        return (static_cast<size_t>(x) << 8) | (static_cast<size_t>(z) << 4) | static_cast<size_t>(y);
+    }
+};
+
+// 4x4x4 bricks, with both the bricks and the blocks inside each brick in
+// Morton (Z-curve) order, so all six neighbors are usually in the same brick
+struct MortonBrickLayout {
+    static constexpr const char* kName = "morton";
+    static size_t Index(int x, int y, int z) {
+        return (Morton(x >> 2, y >> 2, z >> 2) << 6) | Morton(x & 3, y & 3, z & 3);
+    }
+
+private:
+    static size_t Spread(int v) {
+        return static_cast<size_t>((v & 1) | ((v & 2) << 2));
+    }
+    static size_t Morton(int x, int y, int z) {
+        return Spread(x) | (Spread(y) << 1) | (Spread(z) << 2);
+    }
+};
+
+#if defined(RTXBLOCKS_CHUNK_LAYOUT_COLUMN)
+using ChunkLayout = ColumnLayout;
+#elif defined(RTXBLOCKS_CHUNK_LAYOUT_MORTON)
+using ChunkLayout = MortonBrickLayout;
+#else
+using ChunkLayout = XMajorLayout;
+#endif
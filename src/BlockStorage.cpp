@@ -0,0 +1,217 @@
+#include "BlockStorage.h"
+#include <algorithm>
+
+DenseBlockStorage::DenseBlockStorage(size_t size, BlockType fill)
+    : m_blocks(size, fill) {
+}
+
+void DenseBlockStorage::Fill(BlockType type) {
+    std::fill(m_blocks.begin(), m_blocks.end(), type);
+}
+
+void DenseBlockStorage::ReadAll(BlockType* out) const {
+    std::copy(m_blocks.begin(), m_blocks.end(), out);
+}
+
+bool DenseBlockStorage::IsUniform(BlockType& type) const {
+    if (m_blocks.empty()) {
+        return false;
+    }
+    type = m_blocks[0];
+    for (BlockType block : m_blocks) {
+        if (block != type) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void DenseBlockStorage::CountTypes(std::array<uint16_t, static_cast<size_t>(BlockType::Count)>& counts) const {
+    counts.fill(0);
+    for (BlockType block : m_blocks) {
+        counts[static_cast<size_t>(block)]++;
+    }
+}
+
+size_t DenseBlockStorage::GetMemoryUsage() const {
+    return sizeof(*this) + m_blocks.capacity() * sizeof(BlockType);
+}
+
+namespace {
+    uint32_t Log2(uint32_t value) {
+        uint32_t result = 0;
+        while (value > 1) {
+            value >>= 1;
+            result++;
+        }
+        return result;
+    }
+}
+
+PaletteBlockStorage::PaletteBlockStorage(size_t size, BlockType fill)
+    : m_size(size)
+    , m_bitsPerEntry(0)
+    , m_entryMask(0)
+    , m_wordShift(0)
+    , m_wordMask(0) {
+    Fill(fill);
+}
+
+void PaletteBlockStorage::Fill(BlockType type) {
+    m_palette.assign(1, type);
+    m_paletteCounts.assign(1, static_cast<uint32_t>(m_size));
+    m_paletteLookup.fill(kNoPaletteEntry);
+    m_paletteLookup[static_cast<size_t>(type)] = 0;
+
+    m_bitsPerEntry = 0;
+    Resize(1);
+}
+
+uint32_t PaletteBlockStorage::GetPaletteIndex(size_t index) const {
+    uint64_t word = m_words[index >> m_wordShift];
+    uint32_t shift = static_cast<uint32_t>(index & m_wordMask) * m_bitsPerEntry;
+    return static_cast<uint32_t>((word >> shift) & m_entryMask);
+}
+
+void PaletteBlockStorage::SetPaletteIndex(size_t index, uint32_t paletteIndex) {
+    uint64_t& word = m_words[index >> m_wordShift];
+    uint32_t shift = static_cast<uint32_t>(index & m_wordMask) * m_bitsPerEntry;
+    word &= ~(static_cast<uint64_t>(m_entryMask) << shift);
+    word |= static_cast<uint64_t>(paletteIndex) << shift;
+}
+
+uint32_t PaletteBlockStorage::FindOrAddPaletteEntry(BlockType type) {
+    uint8_t existing = m_paletteLookup[static_cast<size_t>(type)];
+    if (existing != kNoPaletteEntry) {
+        return existing;
+    }
+
+    // Reuse a slot whose type no longer occurs anywhere
+    uint32_t slot = static_cast<uint32_t>(m_palette.size());
+    for (uint32_t i = 0; i < m_palette.size(); i++) {
+        if (m_paletteCounts[i] == 0) {
+            slot = i;
+            break;
+        }
+    }
+
+    if (slot == m_palette.size()) {
+        m_palette.push_back(type);
+        m_paletteCounts.push_back(0);
+        if (m_palette.size() > (1u << m_bitsPerEntry)) {
+            Resize(m_bitsPerEntry * 2);
+        }
+    } else {
+        m_paletteLookup[static_cast<size_t>(m_palette[slot])] = kNoPaletteEntry;
+        m_palette[slot] = type;
+    }
+
+    m_paletteLookup[static_cast<size_t>(type)] = static_cast<uint8_t>(slot);
+    return slot;
+}
+
+void PaletteBlockStorage::Set(size_t index, BlockType type) {
+    uint32_t oldIndex = GetPaletteIndex(index);
+    if (m_palette[oldIndex] == type) {
+        return;
+    }
+
+    uint32_t newIndex = FindOrAddPaletteEntry(type);
+    m_paletteCounts[oldIndex]--;
+    m_paletteCounts[newIndex]++;
+    SetPaletteIndex(index, newIndex);
+}
+
+void PaletteBlockStorage::AddTypes(uint32_t typeMask) {
+    size_t needed = m_palette.size();
+    for (uint32_t type = 0; type < static_cast<uint32_t>(BlockType::Count); type++) {
+        if ((typeMask & (1u << type)) && m_paletteLookup[type] == kNoPaletteEntry) {
+            needed++;
+        }
+    }
+    uint32_t bitsPerEntry = m_bitsPerEntry;
+    while ((1u << bitsPerEntry) < needed) {
+        bitsPerEntry *= 2;
+    }
+    if (bitsPerEntry != m_bitsPerEntry) {
+        Resize(bitsPerEntry);
+    }
+
+    for (uint32_t type = 0; type < static_cast<uint32_t>(BlockType::Count); type++) {
+        if (typeMask & (1u << type)) {
+            FindOrAddPaletteEntry(static_cast<BlockType>(type));
+        }
+    }
+}
+
+void PaletteBlockStorage::Resize(uint32_t bitsPerEntry) {
+    // Entry widths are powers of two so an entry never straddles two words
+    std::vector<uint64_t> oldWords;
+    oldWords.swap(m_words);
+    uint32_t oldBits = m_bitsPerEntry;
+    uint32_t oldMask = m_entryMask;
+    uint32_t oldShift = m_wordShift;
+    size_t oldWordMask = m_wordMask;
+
+    uint32_t entriesPerWord = 64 / bitsPerEntry;
+    m_bitsPerEntry = bitsPerEntry;
+    m_entryMask = (1u << bitsPerEntry) - 1;
+    m_wordShift = Log2(entriesPerWord);
+    m_wordMask = entriesPerWord - 1;
+    m_words.assign((m_size + entriesPerWord - 1) / entriesPerWord, 0);
+
+    // Nothing to repack while every index is 0, as in storage just filled
+    // with one type
+    if (oldBits == 0 || std::all_of(oldWords.begin(), oldWords.end(), [](uint64_t word) { return word == 0; })) {
+        return;
+    }
+
+    // Each new word is packed in a register and stored once
+    size_t i = 0;
+    for (uint64_t& newWord : m_words) {
+        uint64_t packed = 0;
+        for (uint32_t entry = 0; entry < entriesPerWord && i < m_size; entry++, i++) {
+            uint64_t word = oldWords[i >> oldShift];
+            uint32_t shift = static_cast<uint32_t>(i & oldWordMask) * oldBits;
+            packed |= ((word >> shift) & oldMask) << (entry * bitsPerEntry);
+        }
+        newWord = packed;
+    }
+}
+
+void PaletteBlockStorage::ReadAll(BlockType* out) const {
+    // Entries never straddle words, as the index width divides 64
+    const size_t entriesPerWord = m_wordMask + 1;
+    for (size_t index = 0; index < m_size; index += entriesPerWord) {
+        uint64_t word = m_words[index >> m_wordShift];
+        size_t count = std::min(entriesPerWord, m_size - index);
+        for (size_t i = 0; i < count; i++, word >>= m_bitsPerEntry) {
+            out[index + i] = m_palette[word & m_entryMask];
+        }
+    }
+}
+
+bool PaletteBlockStorage::IsUniform(BlockType& type) const {
+    for (size_t i = 0; i < m_palette.size(); i++) {
+        if (m_paletteCounts[i] == m_size) {
+            type = m_palette[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+void PaletteBlockStorage::CountTypes(std::array<uint16_t, static_cast<size_t>(BlockType::Count)>& counts) const {
+    // Each type has at most one palette entry
+    counts.fill(0);
+    for (size_t i = 0; i < m_palette.size(); i++) {
+        counts[static_cast<size_t>(m_palette[i])] += static_cast<uint16_t>(m_paletteCounts[i]);
+    }
+}
+
+size_t PaletteBlockStorage::GetMemoryUsage() const {
+    return sizeof(*this) +
+           m_words.capacity() * sizeof(uint64_t) +
+           m_palette.capacity() * sizeof(BlockType) +
+           m_paletteCounts.capacity() * sizeof(uint32_t);
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include "Block.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Flat one-byte-per-voxel storage (the original chunk layout)
+class DenseBlockStorage {
+public:
+    explicit DenseBlockStorage(size_t size, BlockType fill = BlockType::Air);
+
+    BlockType Get(size_t index) const { return m_blocks[index]; }
+    void Set(size_t index, BlockType type) { m_blocks[index] = type; }
+    void Fill(BlockType type);
+    // Every block in index order into out, which holds GetSize() entries
+    void ReadAll(BlockType* out) const;
+    bool IsUniform(BlockType& type) const;
+    // Number of blocks of each type
+    void CountTypes(std::array<uint16_t, static_cast<size_t>(BlockType::Count)>& counts) const;
+    void AddTypes(uint32_t typeMask) {}
+
+    size_t GetSize() const { return m_blocks.size(); }
+    size_t GetMemoryUsage() const;
+
+private:
+    std::vector<BlockType> m_blocks;
+};
+
+// Small palette of block types plus bit-packed palette indices.
+// Indices start at 1 bit and widen to 2/4/8 bits as new types appear,
+// so a chunk holding a handful of types costs a fraction of the dense array.
+class PaletteBlockStorage {
+public:
+    explicit PaletteBlockStorage(size_t size, BlockType fill = BlockType::Air);
+
+    BlockType Get(size_t index) const {
+        uint64_t word = m_words[index >> m_wordShift];
+        uint32_t shift = static_cast<uint32_t>(index & m_wordMask) * m_bitsPerEntry;
+        return m_palette[(word >> shift) & m_entryMask];
+    }
+    void Set(size_t index, BlockType type);
+    void Fill(BlockType type);
+    // Unpacks a word at a time, far cheaper than GetSize() calls to Get
+    void ReadAll(BlockType* out) const;
+    bool IsUniform(BlockType& type) const;
+    // From the palette counts, without reading the blocks
+    void CountTypes(std::array<uint16_t, static_cast<size_t>(BlockType::Count)>& counts) const;
+    // Adds palette entries for the types (bit 1 << type) ahead of writing
+    // them, widening the indices at most once
+    void AddTypes(uint32_t typeMask);
+
+    size_t GetSize() const { return m_size; }
+    size_t GetMemoryUsage() const;
+    uint32_t GetBitsPerEntry() const { return m_bitsPerEntry; }
+    size_t GetPaletteSize() const { return m_palette.size(); }
+
+private:
+    static constexpr uint8_t kNoPaletteEntry = 0xFF;
+
+    uint32_t GetPaletteIndex(size_t index) const;
+    void SetPaletteIndex(size_t index, uint32_t paletteIndex);
+    uint32_t FindOrAddPaletteEntry(BlockType type);
+    void Resize(uint32_t bitsPerEntry);
+
+    size_t m_size;
+    uint32_t m_bitsPerEntry;
+    uint32_t m_entryMask;
+    uint32_t m_wordShift;
+    size_t m_wordMask;
+    std::vector<uint64_t> m_words;
+
+    std::vector<BlockType> m_palette;
+    std::vector<uint32_t> m_paletteCounts;
+    std::array<uint8_t, 256> m_paletteLookup;
+};
+
+#ifdef RTXBLOCKS_DENSE_CHUNK_STORAGE
+using ChunkBlockStorage = DenseBlockStorage;
+#else
+using ChunkBlockStorage = PaletteBlockStorage;
+#endif
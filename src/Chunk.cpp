@@ -1,46 +1,684 @@
 #include "Chunk.h"
 #include "BlockDatabase.h"
+#include <algorithm>
+#include <cmath>
 #include <cstring>
+#include <iterator>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
-Chunk::Chunk(int chunkX, int chunkZ)
+namespace {
+    int CountBits(uint64_t bits) {
+#ifdef _MSC_VER
+        return static_cast<int>(__popcnt64(bits));
+#else
+        return __builtin_popcountll(bits);
+#endif
+    }
+
+    // ChunkSection::GetTypeBit of every solid type
+    uint32_t GetSolidTypeMask() {
+        static const uint32_t mask = [] {
+            uint32_t solid = 0;
+            for (uint32_t type = 0; type < static_cast<uint32_t>(BlockType::Count); type++) {
+                if (BlockDatabase::IsSolid(static_cast<BlockType>(type))) solid |= 1u << type;
+            }
+            return solid;
+        }();
+        return mask;
+    }
+
+    // Index of the lowest set bit; bits must not be 0
+    int LowestBit(uint64_t bits) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, bits);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(bits);
+#endif
+    }
+
+    // 0x01 in every byte of bytes that is 0, 0x00 in the others
+    uint64_t ZeroBytes(uint64_t bytes) {
+        const uint64_t low7 = 0x7F7F7F7F7F7F7F7Full;
+        return ~(((bytes & low7) + low7) | bytes | low7) >> 7;
+    }
+}
+
+template <typename Shape>
+BasicChunk<Shape>::BasicChunk(int chunkX, int chunkZ, int chunkY)
     : m_chunkX(chunkX)
     , m_chunkZ(chunkZ)
+    , m_chunkY(chunkY)
+    , m_revision(0)
     , m_needsMeshUpdate(true)
     , m_needsBufferUpdate(true)
     , m_isEmpty(true)
-    , m_indexCount(0) {
-    std::memset(m_blocks, 0, sizeof(m_blocks));
+    , m_hasMesh(false)
+    , m_isModified(false)
+    , m_quadCount(0)
+    , m_transparentQuadCount(0)
+    , m_gpuBytes(0)
+    , m_reportedMemory{}
+    , m_lastVisibleFrame(0) {
+    ResetExtents();
 }
 
-Chunk::~Chunk() {
+template <typename Shape>
+BasicChunk<Shape>::~BasicChunk() {
 }
 
-void Chunk::SetBlock(int x, int y, int z, BlockType type) {
+template <typename Shape>
+void BasicChunk<Shape>::Retire() {
+    for (auto& section : m_sections) {
+        section = ChunkSection();
+    }
+    ClearBorders();
+    ResetExtents();
+
+    // Swapped out rather than cleared, so a pooled chunk holds no mesh memory
+    // that MemoryTracker no longer sees, including the old mesh a snapshot
+    // took over in SwapMesh
+    std::vector<MeshQuad>().swap(m_quads);
+    std::vector<MeshQuad>().swap(m_transparentQuads);
+
+    m_quadBuffer.Reset();
+    m_transparentQuadBuffer.Reset();
+    m_offsetBuffer.Reset();
+    m_quadCount = 0;
+    m_transparentQuadCount = 0;
+    m_gpuBytes = 0;
+}
+
+template <typename Shape>
+void BasicChunk<Shape>::Reset(int chunkX, int chunkZ, int chunkY) {
+    m_chunkX = chunkX;
+    m_chunkZ = chunkZ;
+    m_chunkY = chunkY;
+    m_reportedMemory.fill(0);
+    m_lastVisibleFrame = 0;
+    // Not reset to 0: results for this object's previous life must not match
+    MarkForMeshUpdate();
+    m_isEmpty = true;
+    m_hasMesh = false;
+    m_isModified = false;
+}
+
+template <typename Shape>
+void BasicChunk<Shape>::SetBlock(int x, int y, int z, BlockType type) {
     if (!IsBlockInBounds(x, y, z)) return;
 
-    m_blocks[x][y][z] = Block(type);
-    m_needsMeshUpdate = true;
-    m_needsBufferUpdate = true;
+    ChunkSection& section = GetSectionAt(x, y, z);
+    BlockType oldType = section.Get(x & SECTION_MASK, y & SECTION_MASK, z & SECTION_MASK);
+    if (oldType == type) return;
+
+    section.Set(x & SECTION_MASK, y & SECTION_MASK, z & SECTION_MASK, type);
+    UpdateExtents(x, y, z, oldType, type);
+    MarkForMeshUpdate();
 
     if (type != BlockType::Air) {
         m_isEmpty = false;
     }
 }
 
-Block Chunk::GetBlock(int x, int y, int z) const {
+template <typename Shape>
+Block BasicChunk<Shape>::GetBlock(int x, int y, int z) const {
     if (!IsBlockInBounds(x, y, z)) {
         return Block(BlockType::Air);
     }
-    return m_blocks[x][y][z];
+    return Block(GetBlockType(x, y, z));
+}
+
+template <typename Shape>
+void BasicChunk<Shape>::ResetExtents() {
+    for (int x = 0; x < Size; x++) {
+        for (int z = 0; z < Size; z++) {
+            m_heightmap[x][z] = -1;
+        }
+    }
+    std::fill(std::begin(m_layerBlockCounts), std::end(m_layerBlockCounts), 0);
+    m_minY = Height;
+    m_maxY = -1;
+}
+
+template <typename Shape>
+void BasicChunk<Shape>::UpdateExtents(int x, int y, int z, BlockType oldType, BlockType newType) {
+    // Column heightmap
+    bool isSolid = BlockDatabase::IsSolid(newType);
+    int16_t& height = m_heightmap[x][z];
+    if (isSolid && y > height) {
+        height = static_cast<int16_t>(y);
+    } else if (!isSolid && y == height) {
+        int top = y - 1;
+        while (top >= 0 && !BlockDatabase::IsSolid(GetBlock(x, top, z).type)) {
+            top--;
+        }
+        height = static_cast<int16_t>(top);
+    }
+
+    // Occupied y range
+    bool wasAir = oldType == BlockType::Air;
+    bool isAir = newType == BlockType::Air;
+    if (wasAir && !isAir) {
+        if (m_layerBlockCounts[y]++ == 0) {
+            m_minY = std::min(m_minY, y);
+            m_maxY = std::max(m_maxY, y);
+        }
+    } else if (!wasAir && isAir) {
+        if (--m_layerBlockCounts[y] == 0) {
+            while (m_minY <= m_maxY && m_layerBlockCounts[m_minY] == 0) m_minY++;
+            while (m_maxY >= m_minY && m_layerBlockCounts[m_maxY] == 0) m_maxY--;
+            if (m_minY > m_maxY) {
+                m_minY = Height;
+                m_maxY = -1;
+            }
+        }
+    }
+}
+
+template <typename Shape>
+void BasicChunk<Shape>::RebuildExtents() {
+    ResetExtents();
+
+    for (int index = 0; index < SectionCount; index++) {
+        const ChunkSection& section = m_sections[index];
+        int baseY = (index / (Shape::SectionsXZ * Shape::SectionsXZ)) * SECTION_SIZE;
+        if (section.IsUniform()) {
+            if (section.GetUniformType() != BlockType::Air) {
+                for (int y = 0; y < SECTION_SIZE; y++) {
+                    m_layerBlockCounts[baseY + y] += SECTION_SIZE * SECTION_SIZE;
+                }
+            }
+            continue;
+        }
+        for (int x = 0; x < SECTION_SIZE; x++) {
+            for (int y = 0; y < SECTION_SIZE; y++) {
+                for (int z = 0; z < SECTION_SIZE; z++) {
+                    if (section.Get(x, y, z) != BlockType::Air) {
+                        m_layerBlockCounts[baseY + y]++;
+                    }
+                }
+            }
+        }
+    }
+
+    for (int y = 0; y < Height; y++) {
+        if (m_layerBlockCounts[y] > 0) {
+            m_minY = std::min(m_minY, y);
+            m_maxY = y;
+        }
+    }
+
+    for (int x = 0; x < Size; x++) {
+        for (int z = 0; z < Size; z++) {
+            RebuildHeight(x, z);
+        }
+    }
+}
+
+template <typename Shape>
+bool BasicChunk<Shape>::ClipBox(int& minX, int& minY, int& minZ, int& maxX, int& maxY, int& maxZ) const {
+    minX = std::max(minX, 0);
+    minY = std::max(minY, 0);
+    minZ = std::max(minZ, 0);
+    maxX = std::min(maxX, Size - 1);
+    maxY = std::min(maxY, Height - 1);
+    maxZ = std::min(maxZ, Size - 1);
+    return minX <= maxX && minY <= maxY && minZ <= maxZ;
+}
+
+template <typename Shape>
+bool BasicChunk<Shape>::FillSection(BulkEdit& edit, int index, int baseY, BlockType type) {
+    ChunkSection& section = m_sections[index];
+    if (section.GetStateCount() > 0 && BlockDatabase::HasState(type) && section.Contains(type)) {
+        return false;
+    }
+
+    const int layerSize = SECTION_SIZE * SECTION_SIZE;
+    for (int y = 0; y < SECTION_SIZE; y++) {
+        int oldCount = 0;
+        if (!section.IsUniform()) {
+            for (int x = 0; x < SECTION_SIZE; x++) {
+                for (int z = 0; z < SECTION_SIZE; z++) {
+                    oldCount += section.Get(x, y, z) != BlockType::Air ? 1 : 0;
+                }
+            }
+        } else if (section.GetUniformType() != BlockType::Air) {
+            oldCount = layerSize;
+        }
+        m_layerBlockCounts[baseY + y] += (type != BlockType::Air ? layerSize : 0) - oldCount;
+    }
+
+    bool isSolid = BlockDatabase::IsSolid(type);
+    int baseX = (index / Shape::SectionsXZ % Shape::SectionsXZ) * SECTION_SIZE;
+    int baseZ = (index % Shape::SectionsXZ) * SECTION_SIZE;
+    for (int x = baseX; x < baseX + SECTION_SIZE; x++) {
+        for (int z = baseZ; z < baseZ + SECTION_SIZE; z++) {
+            int height = m_heightmap[x][z];
+            if (isSolid) {
+                UpdateBulkHeight(edit, x, baseY + SECTION_SIZE - 1, z, true);
+            } else if (height >= baseY && height < baseY + SECTION_SIZE) {
+                edit.staleHeights.set(x * Size + z);
+            }
+        }
+    }
+
+    section.Fill(type);
+    edit.sections.set(index);
+    return true;
+}
+
+template <typename Shape>
+void BasicChunk<Shape>::RebuildHeight(int x, int z) {
+    // Walk the column down from the top, skipping whole sections
+    int sectionX = x >> SECTION_SHIFT;
+    int sectionZ = z >> SECTION_SHIFT;
+    int localX = x & SECTION_MASK;
+    int localZ = z & SECTION_MASK;
+    m_heightmap[x][z] = -1;
+    for (int sectionY = Shape::SectionsY - 1; sectionY >= 0 && m_heightmap[x][z] < 0; sectionY--) {
+        const ChunkSection& section = m_sections[GetSectionIndex(sectionX, sectionY, sectionZ)];
+        int baseY = sectionY * SECTION_SIZE;
+        if (section.IsUniform()) {
+            if (BlockDatabase::IsSolid(section.GetUniformType())) {
+                m_heightmap[x][z] = static_cast<int16_t>(baseY + SECTION_SIZE - 1);
+            }
+            continue;
+        }
+        if ((section.GetTypeMask() & GetSolidTypeMask()) == 0) {
+            continue;
+        }
+        for (int y = SECTION_SIZE - 1; y >= 0; y--) {
+            if (BlockDatabase::IsSolid(section.Get(localX, y, localZ))) {
+                m_heightmap[x][z] = static_cast<int16_t>(baseY + y);
+                break;
+            }
+        }
+    }
+}
+
+template <typename Shape>
+bool BasicChunk<Shape>::FinishBulkEdit(const BulkEdit& edit) {
+    if (edit.sections.none()) {
+        return false;
+    }
+
+    // Sections left holding one type collapse back to a tag. Interning is
+    // skipped: edited sections rarely match another and hashing them costs
+    // more than the edit
+    for (int index = 0; index < SectionCount; index++) {
+        if (edit.sections[index]) m_sections[index].CollapseIfUniform();
+    }
+
+    m_minY = Height;
+    m_maxY = -1;
+    for (int y = 0; y < Height; y++) {
+        if (m_layerBlockCounts[y] > 0) {
+            m_minY = std::min(m_minY, y);
+            m_maxY = y;
+        }
+    }
+    if (m_minY > m_maxY) {
+        m_minY = Height;
+    }
+    for (int x = 0; x < Size; x++) {
+        for (int z = 0; z < Size; z++) {
+            if (edit.staleHeights[x * Size + z]) RebuildHeight(x, z);
+        }
+    }
+
+    m_isEmpty = m_minY > m_maxY;
+    MarkForMeshUpdate();
+    return true;
+}
+
+template <typename Shape>
+bool BasicChunk<Shape>::FillBox(int minX, int minY, int minZ, int maxX, int maxY, int maxZ, BlockType type) {
+    if (!ClipBox(minX, minY, minZ, maxX, maxY, maxZ)) return false;
+
+    BulkEdit edit;
+    uint32_t typeBit = ChunkSection::GetTypeBit(type);
+    bool isSolid = BlockDatabase::IsSolid(type);
+    ForEachSectionInBox(minX, minY, minZ, maxX, maxY, maxZ,
+        [&](int index, int baseY, int x0, int y0, int z0, int x1, int y1, int z1) {
+            ChunkSection& section = m_sections[index];
+            // Holding nothing but the type (uniform or not yet collapsed)
+            if (section.GetTypeMask() == typeBit) {
+                return;
+            }
+            if ((x0 | y0 | z0) == 0 && (x1 & y1 & z1) == SECTION_MASK && FillSection(edit, index, baseY, type)) {
+                return;
+            }
+            // Blocks already of the type are left alone, keeping their state,
+            // and the section is only marked once one really changes
+            int baseX = (index / Shape::SectionsXZ % Shape::SectionsXZ) * SECTION_SIZE;
+            int baseZ = (index % Shape::SectionsXZ) * SECTION_SIZE;
+            for (int x = x0; x <= x1; x++) {
+                for (int z = z0; z <= z1; z++) {
+                    int height = m_heightmap[baseX + x][baseZ + z];
+                    bool changed = false;
+                    for (int y = y0; y <= y1; y++) {
+                        BlockType oldType = section.Get(x, y, z);
+                        if (oldType == type) continue;
+                        if (!edit.sections[index]) {
+                            section.BeginWrites(typeBit);
+                            edit.sections.set(index);
+                        }
+                        CountLayerChange(baseY + y, oldType, type);
+                        section.Write(x, y, z, type);
+                        changed = true;
+                    }
+                    if (!changed) continue;
+                    // The span is one type, so the column's height moves at most once
+                    if (isSolid) {
+                        UpdateBulkHeight(edit, baseX + x, baseY + y1, baseZ + z, true);
+                    } else if (height >= baseY + y0 && height <= baseY + y1) {
+                        edit.staleHeights.set((baseX + x) * Size + baseZ + z);
+                    }
+                }
+            }
+            if (edit.sections[index]) section.EndWrites();
+        });
+
+    return FinishBulkEdit(edit);
+}
+
+template <typename Shape>
+bool BasicChunk<Shape>::ReplaceInBox(int minX, int minY, int minZ, int maxX, int maxY, int maxZ, BlockType from, BlockType to) {
+    if (from == to || !ClipBox(minX, minY, minZ, maxX, maxY, maxZ)) return false;
+
+    BulkEdit edit;
+    ForEachSectionInBox(minX, minY, minZ, maxX, maxY, maxZ,
+        [&](int index, int baseY, int x0, int y0, int z0, int x1, int y1, int z1) {
+            ChunkSection& section = m_sections[index];
+            if (!section.Contains(from)) {
+                return;
+            }
+            // Every block of a uniform section changes type, so no state survives
+            if (section.IsUniform() && (x0 | y0 | z0) == 0 && (x1 & y1 & z1) == SECTION_MASK) {
+                FillSection(edit, index, baseY, to);
+                return;
+            }
+            for (int x = x0; x <= x1; x++) {
+                for (int y = y0; y <= y1; y++) {
+                    for (int z = z0; z <= z1; z++) {
+                        if (section.Get(x, y, z) == from) {
+                            WriteBlock(edit, index, ChunkSection::GetTypeBit(to), x, y, z, from, to);
+                        }
+                    }
+                }
+            }
+            if (edit.sections[index]) section.EndWrites();
+        });
+
+    return FinishBulkEdit(edit);
+}
+
+template <typename Shape>
+bool BasicChunk<Shape>::FillSphere(int centerX, int centerY, int centerZ, int radius, BlockType type) {
+    int minX = centerX - radius, minY = centerY - radius, minZ = centerZ - radius;
+    int maxX = centerX + radius, maxY = centerY + radius, maxZ = centerZ + radius;
+    if (radius < 0 || !ClipBox(minX, minY, minZ, maxX, maxY, maxZ)) return false;
+
+    BulkEdit edit;
+    uint32_t typeBit = ChunkSection::GetTypeBit(type);
+    int radiusSq = radius * radius;
+    ForEachSectionInBox(minX, minY, minZ, maxX, maxY, maxZ,
+        [&](int index, int baseY, int x0, int y0, int z0, int x1, int y1, int z1) {
+            ChunkSection& section = m_sections[index];
+            if (section.IsUniform() && section.GetUniformType() == type) {
+                return;
+            }
+            int baseX = (index / Shape::SectionsXZ % Shape::SectionsXZ) * SECTION_SIZE;
+            int baseZ = (index % Shape::SectionsXZ) * SECTION_SIZE;
+
+            // Sections with every corner inside the sphere are filled whole
+            int farX = std::max(std::abs(baseX - centerX), std::abs(baseX + SECTION_MASK - centerX));
+            int farY = std::max(std::abs(baseY - centerY), std::abs(baseY + SECTION_MASK - centerY));
+            int farZ = std::max(std::abs(baseZ - centerZ), std::abs(baseZ + SECTION_MASK - centerZ));
+            if (farX * farX + farY * farY + farZ * farZ <= radiusSq && FillSection(edit, index, baseY, type)) {
+                return;
+            }
+
+            // Otherwise each column inside the sphere is one span of y
+            for (int x = x0; x <= x1; x++) {
+                for (int z = z0; z <= z1; z++) {
+                    int dx = baseX + x - centerX;
+                    int dz = baseZ + z - centerZ;
+                    int remaining = radiusSq - dx * dx - dz * dz;
+                    if (remaining < 0) continue;
+                    int halfHeight = static_cast<int>(std::sqrt(static_cast<double>(remaining)));
+                    while (halfHeight * halfHeight > remaining) halfHeight--;
+                    while ((halfHeight + 1) * (halfHeight + 1) <= remaining) halfHeight++;
+                    int spanMin = std::max(centerY - halfHeight - baseY, y0);
+                    int spanMax = std::min(centerY + halfHeight - baseY, y1);
+                    for (int y = spanMin; y <= spanMax; y++) {
+                        BlockType oldType = section.Get(x, y, z);
+                        if (oldType != type) {
+                            WriteBlock(edit, index, typeBit, x, y, z, oldType, type);
+                        }
+                    }
+                }
+            }
+            if (edit.sections[index] && !section.IsUniform()) section.EndWrites();
+        });
+
+    return FinishBulkEdit(edit);
+}
+
+template <typename Shape>
+bool BasicChunk<Shape>::Paste(const BlockBuffer& buffer, int originX, int originY, int originZ, bool skipAir) {
+    int minX = originX, minY = originY, minZ = originZ;
+    int maxX = originX + buffer.sizeX - 1, maxY = originY + buffer.sizeY - 1, maxZ = originZ + buffer.sizeZ - 1;
+    if (!ClipBox(minX, minY, minZ, maxX, maxY, maxZ)) return false;
+
+    BulkEdit edit;
+    ForEachSectionInBox(minX, minY, minZ, maxX, maxY, maxZ,
+        [&](int index, int baseY, int x0, int y0, int z0, int x1, int y1, int z1) {
+            ChunkSection& section = m_sections[index];
+            int bufferX = (index / Shape::SectionsXZ % Shape::SectionsXZ) * SECTION_SIZE - originX;
+            int bufferY = baseY - originY;
+            int bufferZ = (index % Shape::SectionsXZ) * SECTION_SIZE - originZ;
+
+            // The buffer's types first, from its bytes alone: any the section
+            // lacks will be written, so the storage makes room for them at once
+            uint32_t writtenTypes = 0;
+            for (int x = x0; x <= x1; x++) {
+                for (int y = y0; y <= y1; y++) {
+                    const BlockType* row = &buffer.blocks[buffer.GetIndex(bufferX + x, bufferY + y, bufferZ + z0)];
+                    for (int z = z0; z <= z1; z++) {
+                        writtenTypes |= ChunkSection::GetTypeBit(row[z - z0]);
+                    }
+                }
+            }
+            if (skipAir) writtenTypes &= ~ChunkSection::GetTypeBit(BlockType::Air);
+            if (writtenTypes == 0) return;
+
+            for (int x = x0; x <= x1; x++) {
+                for (int y = y0; y <= y1; y++) {
+                    const BlockType* row = &buffer.blocks[buffer.GetIndex(bufferX + x, bufferY + y, bufferZ + z0)];
+                    for (int z = z0; z <= z1; z++) {
+                        BlockType type = row[z - z0];
+                        if (skipAir && type == BlockType::Air) continue;
+                        BlockType oldType = section.Get(x, y, z);
+                        if (oldType != type) {
+                            WriteBlock(edit, index, writtenTypes, x, y, z, oldType, type);
+                        }
+                    }
+                }
+            }
+            if (edit.sections[index]) section.EndWrites();
+        });
+
+    return FinishBulkEdit(edit);
+}
+
+template <typename Shape>
+void BasicChunk<Shape>::LoadSections(const SectionArray& sections) {
+    m_sections = sections;
+    CompactSections();
+    RebuildExtents();
+    m_isEmpty = m_minY > m_maxY;
+    MarkForMeshUpdate();
+}
+
+template <typename Shape>
+void BasicChunk<Shape>::CopyBlocksFrom(const BasicChunk& other) {
+    m_chunkX = other.m_chunkX;
+    m_chunkZ = other.m_chunkZ;
+    m_chunkY = other.m_chunkY;
+    m_sections = other.m_sections;
+    std::copy(&other.m_heightmap[0][0], &other.m_heightmap[0][0] + Shape::Size * Shape::Size, &m_heightmap[0][0]);
+    std::copy(std::begin(other.m_layerBlockCounts), std::end(other.m_layerBlockCounts), std::begin(m_layerBlockCounts));
+    m_minY = other.m_minY;
+    m_maxY = other.m_maxY;
+    m_isEmpty = other.m_isEmpty;
+    m_isModified = other.m_isModified;
+    MarkForMeshUpdate();
+}
+
+template <typename Shape>
+void BasicChunk<Shape>::CopyBorderFrom(BlockFace::Face side, const BasicChunk* neighbor) {
+    if (!neighbor) {
+        if (m_borders) {
+            (*m_borders)[side] = NeighborBorder();
+        }
+        return;
+    }
+    if (!m_borders) {
+        m_borders.reset(new std::array<NeighborBorder, 4>());
+    }
+
+    // The neighbor's sections touching this chunk: its last row on the
+    // Left and Back sides, its first on the Right and Front
+    NeighborBorder& border = (*m_borders)[side];
+    int edge = side == BlockFace::Left || side == BlockFace::Back ? Shape::SectionsXZ - 1 : 0;
+    bool alongZ = side == BlockFace::Left || side == BlockFace::Right;
+    for (int sectionY = 0; sectionY < Shape::SectionsY; sectionY++) {
+        for (int along = 0; along < Shape::SectionsXZ; along++) {
+            int index = alongZ ? GetSectionIndex(edge, sectionY, along) : GetSectionIndex(along, sectionY, edge);
+            border.sections[sectionY * Shape::SectionsXZ + along] = neighbor->m_sections[index];
+        }
+    }
+    border.loaded = true;
+}
+
+template <typename Shape>
+BlockType BasicChunk<Shape>::GetBorderBlock(const NeighborBorder& border, BlockFace::Face side, int along, int y) {
+    const ChunkSection& section = border.sections[(y >> SECTION_SHIFT) * Shape::SectionsXZ + (along >> SECTION_SHIFT)];
+    int edge = side == BlockFace::Left || side == BlockFace::Back ? SECTION_MASK : 0;
+    if (side == BlockFace::Left || side == BlockFace::Right) {
+        return section.Get(edge, y & SECTION_MASK, along & SECTION_MASK);
+    }
+    return section.Get(along & SECTION_MASK, y & SECTION_MASK, edge);
+}
+
+template <typename Shape>
+void BasicChunk<Shape>::ClearBorders() {
+    // Keeps the allocation for the pool's next snapshot
+    if (m_borders) {
+        m_borders->fill(NeighborBorder());
+    }
+}
+
+template <typename Shape>
+void BasicChunk<Shape>::SwapMesh(BasicChunk& meshed) {
+    m_quads.swap(meshed.m_quads);
+    m_transparentQuads.swap(meshed.m_transparentQuads);
+    m_needsMeshUpdate = false;
+    m_needsBufferUpdate = true;
+    m_hasMesh = true;
+}
+
+template <typename Shape>
+void BasicChunk<Shape>::CompactSections() {
+    for (auto& section : m_sections) {
+        section.Compact();
+    }
+}
+
+template <typename Shape>
+size_t BasicChunk<Shape>::GetBlockMemoryUsage() const {
+    size_t usage = 0;
+    for (const auto& section : m_sections) {
+        usage += section.GetMemoryUsage();
+    }
+    return usage;
+}
+
+template <typename Shape>
+size_t BasicChunk<Shape>::GetCpuMeshMemoryUsage() const {
+    return (m_quads.capacity() + m_transparentQuads.capacity()) * sizeof(MeshQuad);
+}
+
+template <typename Shape>
+void BasicChunk<Shape>::ReportMemory(MemoryTracker& tracker) {
+    const size_t current[3] = { GetBlockMemoryUsage(), GetCpuMeshMemoryUsage(), m_gpuBytes };
+    const MemoryCategory categories[3] = { MemoryCategory::BlockData, MemoryCategory::CpuMesh, MemoryCategory::GpuMesh };
+    for (int i = 0; i < 3; i++) {
+        tracker.Add(categories[i], static_cast<int64_t>(current[i]) - static_cast<int64_t>(m_reportedMemory[i]));
+        m_reportedMemory[i] = current[i];
+    }
+}
+
+template <typename Shape>
+void BasicChunk<Shape>::WithdrawMemory(MemoryTracker& tracker) {
+    tracker.Add(MemoryCategory::BlockData, -static_cast<int64_t>(m_reportedMemory[0]));
+    tracker.Add(MemoryCategory::CpuMesh, -static_cast<int64_t>(m_reportedMemory[1]));
+    tracker.Add(MemoryCategory::GpuMesh, -static_cast<int64_t>(m_reportedMemory[2]));
+    m_reportedMemory.fill(0);
+}
+
+template <typename Shape>
+void BasicChunk<Shape>::ReleaseCpuMesh() {
+    std::vector<MeshQuad>().swap(m_quads);
+    std::vector<MeshQuad>().swap(m_transparentQuads);
+}
+
+template <typename Shape>
+bool BasicChunk<Shape>::IsSectionSolid(int sectionX, int sectionY, int sectionZ) const {
+    const ChunkSection& section = m_sections[GetSectionIndex(sectionX, sectionY, sectionZ)];
+    return section.IsUniform() && !Block(section.GetUniformType()).IsTransparent();
+}
+
+template <typename Shape>
+BlockState BasicChunk<Shape>::GetBlockState(int x, int y, int z) const {
+    if (!IsBlockInBounds(x, y, z)) {
+        return 0;
+    }
+    return GetSectionAt(x, y, z).GetState(x & SECTION_MASK, y & SECTION_MASK, z & SECTION_MASK);
+}
+
+template <typename Shape>
+bool BasicChunk<Shape>::SetBlockState(int x, int y, int z, BlockState state) {
+    if (!IsBlockInBounds(x, y, z)) return false;
+
+    ChunkSection& section = GetSectionAt(x, y, z);
+    int localX = x & SECTION_MASK;
+    int localY = y & SECTION_MASK;
+    int localZ = z & SECTION_MASK;
+    if (!BlockDatabase::HasState(section.Get(localX, localY, localZ)) ||
+        section.GetState(localX, localY, localZ) == state) {
+        return false;
+    }
+
+    // States aren't meshed, but readers of published copies see them
+    section.SetState(localX, localY, localZ, state);
+    BumpRevision();
+    return true;
 }
 
-bool Chunk::IsBlockInBounds(int x, int y, int z) const {
-    return x >= 0 && x < CHUNK_SIZE &&
-           y >= 0 && y < CHUNK_HEIGHT &&
-           z >= 0 && z < CHUNK_SIZE;
+template <typename Shape>
+bool BasicChunk<Shape>::IsBlockInBounds(int x, int y, int z) const {
+    return x >= 0 && x < Size &&
+           y >= 0 && y < Height &&
+           z >= 0 && z < Size;
 }
 
-bool Chunk::ShouldRenderFace(int x, int y, int z, BlockFace::Face face) const {
+template <typename Shape>
+bool BasicChunk<Shape>::ShouldRenderFace(int x, int y, int z, BlockFace::Face face) const {
     Block currentBlock = GetBlock(x, y, z);
     if (currentBlock.IsAir()) return false;
 
@@ -55,13 +693,16 @@ bool Chunk::ShouldRenderFace(int x, int y, int z, BlockFace::Face face) const {
     case BlockFace::Bottom: ny--; break;
     }
 
-    // If neighbor is out of bounds, render the face
-    if (!IsBlockInBounds(nx, ny, nz)) {
+    Block neighbor;
+    if (IsBlockInBounds(nx, ny, nz)) {
+        neighbor = GetBlock(nx, ny, nz);
+    } else if (const NeighborBorder* border = GetBorder(face)) {
+        neighbor = Block(GetBorderBlock(*border, face, face <= BlockFace::Back ? x : z, y));
+    } else {
+        // Nothing known past this side of the chunk: render the face
         return true;
     }
 
-    Block neighbor = GetBlock(nx, ny, nz);
-
     // Don't render face if neighbor is opaque
     if (!neighbor.IsTransparent()) {
         return false;
@@ -71,8 +712,10 @@ bool Chunk::ShouldRenderFace(int x, int y, int z, BlockFace::Face face) const {
     return neighbor.IsAir() || neighbor.IsLiquid() || neighbor.type != currentBlock.type;
 }
 
-void Chunk::AddBlockFace(const Vector3& pos, BlockFace::Face face, const Vector4& color, bool isTransparent) {
-    Vector3 normals[6] = {
+template <typename Shape>
+void BasicChunk<Shape>::GetFaceCorners(BlockFace::Face face, const Vector4& color, const Vector3& size,
+                                       Vertex (&corners)[4]) {
+    static const Vector3 normals[6] = {
         Vector3(0, 0, 1),   // Front
         Vector3(0, 0, -1),  // Back
         Vector3(-1, 0, 0),  // Left
@@ -81,7 +724,7 @@ void Chunk::AddBlockFace(const Vector3& pos, BlockFace::Face face, const Vector4
         Vector3(0, -1, 0)   // Bottom
     };
 
-    Vector3 vertices[6][4] = {
+    static const Vector3 vertices[6][4] = {
         // Front
         {
             Vector3(0, 0, 1), Vector3(1, 0, 1), Vector3(1, 1, 1), Vector3(0, 1, 1)
@@ -108,156 +751,560 @@ void Chunk::AddBlockFace(const Vector3& pos, BlockFace::Face face, const Vector4
         }
     };
 
-    Vector2 texCoords[4] = {
+    static const Vector2 texCoords[4] = {
         Vector2(0, 1), Vector2(1, 1), Vector2(1, 0), Vector2(0, 0)
     };
 
-    auto& currentVertices = isTransparent ? m_transparentVertices : m_vertices;
-    auto& currentIndices = isTransparent ? m_transparentIndices : m_indices;
-
-    uint32_t baseIndex = static_cast<uint32_t>(currentVertices.size());
-    Vector3 normal = normals[face];
+    // Texture coordinates repeat once per block across stretched faces
+    const Vector3* unit = vertices[face];
+    float texScaleU = std::abs((unit[1] - unit[0]).dot(size));
+    float texScaleV = std::abs((unit[2] - unit[1]).dot(size));
 
     for (int i = 0; i < 4; i++) {
-        Vertex v;
-        v.position = pos + vertices[face][i];
-        v.normal = normal;
-        v.color = color;
-        v.texCoord = texCoords[i];
-        currentVertices.push_back(v);
+        corners[i].position = Vector3(unit[i].x * size.x, unit[i].y * size.y, unit[i].z * size.z);
+        corners[i].normal = normals[face];
+        corners[i].color = color;
+        corners[i].texCoord = Vector2(texCoords[i].x * texScaleU, texCoords[i].y * texScaleV);
     }
-
-    currentIndices.push_back(baseIndex);
-    currentIndices.push_back(baseIndex + 1);
-    currentIndices.push_back(baseIndex + 2);
-    currentIndices.push_back(baseIndex);
-    currentIndices.push_back(baseIndex + 2);
-    currentIndices.push_back(baseIndex + 3);
 }
 
-void Chunk::GenerateMesh() {
-    m_vertices.clear();
-    m_indices.clear();
-    m_transparentVertices.clear();
-    m_transparentIndices.clear();
+template <typename Shape>
+void BasicChunk<Shape>::AppendFace(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices,
+                                   const Vertex (&corners)[4], const Vector3& pos) {
+    uint32_t baseIndex = static_cast<uint32_t>(vertices.size());
+    for (const Vertex& corner : corners) {
+        Vertex v = corner;
+        v.position = pos + corner.position;
+        vertices.push_back(v);
+    }
 
-    // Get chunk world position offset
+    indices.push_back(baseIndex);
+    indices.push_back(baseIndex + 1);
+    indices.push_back(baseIndex + 2);
+    indices.push_back(baseIndex);
+    indices.push_back(baseIndex + 2);
+    indices.push_back(baseIndex + 3);
+}
+
+template <typename Shape>
+void BasicChunk<Shape>::AppendQuads(const std::vector<MeshQuad>& quads, std::vector<Vertex>& vertices,
+                                    std::vector<uint32_t>& indices) const {
     Vector3 chunkOffset = GetWorldPosition();
+    vertices.reserve(vertices.size() + quads.size() * 4);
+    indices.reserve(indices.size() + quads.size() * 6);
+    for (const MeshQuad& quad : quads) {
+        Vertex corners[4];
+        GetFaceCorners(static_cast<BlockFace::Face>(quad.face),
+                       BlockDatabase::GetProperties(static_cast<BlockType>(quad.type)).color,
+                       Vector3(quad.sizeX + 1.0f, quad.sizeY + 1.0f, quad.sizeZ + 1.0f), corners);
+        AppendFace(vertices, indices, corners,
+                   Vector3(chunkOffset.x + quad.x, chunkOffset.y + quad.y, chunkOffset.z + quad.z));
+    }
+}
+
+template <typename Shape>
+void BasicChunk<Shape>::AppendSolidMesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) const {
+    AppendQuads(m_quads, vertices, indices);
+}
+
+template <typename Shape>
+void BasicChunk<Shape>::AppendTransparentMesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) const {
+    AppendQuads(m_transparentQuads, vertices, indices);
+}
+
+template <typename Shape>
+void BasicChunk<Shape>::AddQuad(int x, int y, int z, BlockFace::Face face, BlockType type, int sizeX, int sizeY, int sizeZ) {
+    MeshQuad quad = {
+        static_cast<uint8_t>(x), static_cast<uint8_t>(y), static_cast<uint8_t>(z),
+        static_cast<uint8_t>(face), static_cast<uint8_t>(type),
+        static_cast<uint8_t>(sizeX - 1), static_cast<uint8_t>(sizeY - 1), static_cast<uint8_t>(sizeZ - 1)
+    };
+    (Block(type).IsTransparent() ? m_transparentQuads : m_quads).push_back(quad);
+}
+
+template <typename Shape>
+void BasicChunk<Shape>::AddBlockFaces(int x, int y, int z) {
+    Block block = GetBlock(x, y, z);
+    if (block.IsAir()) return; // Skip air blocks
+
+    for (int face = 0; face < 6; face++) {
+        if (ShouldRenderFace(x, y, z, static_cast<BlockFace::Face>(face))) {
+            AddQuad(x, y, z, static_cast<BlockFace::Face>(face), block.type);
+        }
+    }
+}
+
+template <typename Shape>
+template <typename Fn>
+void BasicChunk<Shape>::ForEachMeshedBlock(int sectionX, int sectionY, int sectionZ, Fn&& visit) const {
+    if (m_sections[GetSectionIndex(sectionX, sectionY, sectionZ)].IsEmpty()) return;
+
+    int baseX = sectionX * SECTION_SIZE;
+    int baseY = sectionY * SECTION_SIZE;
+    int baseZ = sectionZ * SECTION_SIZE;
+
+    if (!IsSectionSolid(sectionX, sectionY, sectionZ)) {
+        int minY = std::max(baseY, m_minY);
+        int maxY = std::min(baseY + SECTION_SIZE - 1, m_maxY);
+        for (int x = baseX; x < baseX + SECTION_SIZE; x++) {
+            for (int y = minY; y <= maxY; y++) {
+                for (int z = baseZ; z < baseZ + SECTION_SIZE; z++) {
+                    visit(x, y, z);
+                }
+            }
+        }
+        return;
+    }
+
+    // Interior blocks of a solid section can never show a face, so only
+    // its shell is visited, minus any side backed by another solid section
+    // of this chunk. Sides on the chunk border are always visited.
+    bool coveredBelow = sectionY > 0 && IsSectionSolid(sectionX, sectionY - 1, sectionZ);
+    bool coveredAbove = sectionY + 1 < Shape::SectionsY && IsSectionSolid(sectionX, sectionY + 1, sectionZ);
+    bool coveredLeft = sectionX > 0 && IsSectionSolid(sectionX - 1, sectionY, sectionZ);
+    bool coveredRight = sectionX + 1 < Shape::SectionsXZ && IsSectionSolid(sectionX + 1, sectionY, sectionZ);
+    bool coveredBack = sectionZ > 0 && IsSectionSolid(sectionX, sectionY, sectionZ - 1);
+    bool coveredFront = sectionZ + 1 < Shape::SectionsXZ && IsSectionSolid(sectionX, sectionY, sectionZ + 1);
+
+    for (int x = baseX; x < baseX + SECTION_SIZE; x++) {
+        for (int z = baseZ; z < baseZ + SECTION_SIZE; z++) {
+            bool onWall = (x == baseX && !coveredLeft) || (x == baseX + SECTION_SIZE - 1 && !coveredRight) ||
+                          (z == baseZ && !coveredBack) || (z == baseZ + SECTION_SIZE - 1 && !coveredFront);
+            if (onWall) {
+                for (int y = baseY; y < baseY + SECTION_SIZE; y++) {
+                    visit(x, y, z);
+                }
+                continue;
+            }
+            if (!coveredBelow) {
+                visit(x, baseY, z);
+            }
+            if (!coveredAbove) {
+                visit(x, baseY + SECTION_SIZE - 1, z);
+            }
+        }
+    }
+}
+
+template <typename Shape>
+template <typename Fn>
+void BasicChunk<Shape>::ForEachVisibleFaceWord(Fn&& visible) const {
+    uint32_t typeMask = 0;
+    for (const ChunkSection& section : m_sections) {
+        typeMask |= section.GetTypeMask();
+    }
+    typeMask &= ~ChunkSection::GetTypeBit(BlockType::Air);
+    if (typeMask == 0) {
+        return;
+    }
+
+    // Occupancy of each type present, and of every opaque block
+    std::array<std::vector<uint64_t>, static_cast<size_t>(BlockType::Count)> occupancy;
+    std::vector<uint64_t> opaque(ColumnMaskWords, 0);
+    for (size_t type = 0; type < occupancy.size(); type++) {
+        if (typeMask & (1u << type)) {
+            occupancy[type].assign(ColumnMaskWords, 0);
+        }
+    }
+
+    std::array<BlockType, SECTION_VOLUME> blocks;
+    for (int index = 0; index < SectionCount; index++) {
+        const ChunkSection& section = m_sections[index];
+        if (section.IsEmpty()) continue;
+
+        int baseX = (index / Shape::SectionsXZ % Shape::SectionsXZ) * SECTION_SIZE;
+        int baseY = (index / (Shape::SectionsXZ * Shape::SectionsXZ)) * SECTION_SIZE;
+        int baseZ = (index % Shape::SectionsXZ) * SECTION_SIZE;
+        // A section's part of a column sits inside one word
+        int word = baseY >> 6;
+        int shift = baseY & 63;
 
-    for (int x = 0; x < CHUNK_SIZE; x++) {
-        for (int y = 0; y < CHUNK_HEIGHT; y++) {
-            for (int z = 0; z < CHUNK_SIZE; z++) {
-                Block block = GetBlock(x, y, z);
-                if (block.IsAir()) continue; // Skip air blocks
+        if (section.IsUniform()) {
+            BlockType type = section.GetUniformType();
+            uint64_t bits = 0xFFFFull << shift;
+            bool isOpaque = !Block(type).IsTransparent();
+            for (int x = 0; x < SECTION_SIZE; x++) {
+                for (int z = 0; z < SECTION_SIZE; z++) {
+                    size_t column = GetColumnOffset(baseX + x, baseZ + z) + word;
+                    occupancy[static_cast<size_t>(type)][column] |= bits;
+                    if (isOpaque) opaque[column] |= bits;
+                }
+            }
+            continue;
+        }
+
+        // Unpacked in one go, then compared a row of z at a time, eight
+        // blocks to a word: byte z % 8 of rowBits[type][y / 8][z / 8] holds
+        // bit y % 8 of the column at z, so no per-block shuffling is needed
+        section.ReadAll(blocks.data());
+        uint32_t sectionTypes = section.GetTypeMask() & typeMask;
+        for (int x = 0; x < SECTION_SIZE; x++) {
+            uint64_t rowBits[static_cast<size_t>(BlockType::Count)][2][2] = {};
+            for (int y = 0; y < SECTION_SIZE; y++) {
+                uint64_t row[2];
+                std::memcpy(row, &blocks[XMajorLayout::Index(x, y, 0)], sizeof(row));
+                // Most rows are all air or all one type
+                size_t first = static_cast<size_t>(blocks[XMajorLayout::Index(x, y, 0)]);
+                uint64_t pattern = 0x0101010101010101ull * first;
+                if (row[0] == pattern && row[1] == pattern) {
+                    if (sectionTypes & (1u << first)) {
+                        rowBits[first][y >> 3][0] |= 0x0101010101010101ull << (y & 7);
+                        rowBits[first][y >> 3][1] |= 0x0101010101010101ull << (y & 7);
+                    }
+                    continue;
+                }
+                for (uint32_t types = sectionTypes; types != 0; types &= types - 1) {
+                    int type = LowestBit(types);
+                    uint64_t typeBytes = 0x0101010101010101ull * type;
+                    rowBits[type][y >> 3][0] |= ZeroBytes(row[0] ^ typeBytes) << (y & 7);
+                    rowBits[type][y >> 3][1] |= ZeroBytes(row[1] ^ typeBytes) << (y & 7);
+                }
+            }
+
+            for (uint32_t types = sectionTypes; types != 0; types &= types - 1) {
+                int type = LowestBit(types);
+                bool isOpaque = !Block(static_cast<BlockType>(type)).IsTransparent();
+                for (int z = 0; z < SECTION_SIZE; z++) {
+                    int byteShift = (z & 7) * 8;
+                    uint64_t bits = ((rowBits[type][0][z >> 3] >> byteShift) & 0xFF) |
+                                    ((rowBits[type][1][z >> 3] >> byteShift) & 0xFF) << 8;
+                    size_t column = GetColumnOffset(baseX + x, baseZ + z) + word;
+                    occupancy[type][column] |= bits << shift;
+                    if (isOpaque) opaque[column] |= bits << shift;
+                }
+            }
+        }
+    }
+
+    // The ring of neighbor columns around the chunk; only opaque blocks and
+    // types this chunk holds can hide a face
+    uint32_t hidingTypes = typeMask;
+    for (size_t type = 0; type < occupancy.size(); type++) {
+        if (!Block(static_cast<BlockType>(type)).IsTransparent()) hidingTypes |= 1u << type;
+    }
+    for (int side = 0; side < 4; side++) {
+        const NeighborBorder* border = GetBorder(static_cast<BlockFace::Face>(side));
+        if (!border) continue;
+
+        for (int index = 0; index < static_cast<int>(border->sections.size()); index++) {
+            const ChunkSection& section = border->sections[index];
+            if ((section.GetTypeMask() & hidingTypes) == 0) continue;
+
+            int baseY = index / Shape::SectionsXZ * SECTION_SIZE;
+            int baseAlong = index % Shape::SectionsXZ * SECTION_SIZE;
+            int word = baseY >> 6;
+            int shift = baseY & 63;
+            for (int along = baseAlong; along < baseAlong + SECTION_SIZE; along++) {
+                size_t column = word;
+                switch (side) {
+                case BlockFace::Front: column += GetColumnOffset(along, Size); break;
+                case BlockFace::Back:  column += GetColumnOffset(along, -1); break;
+                case BlockFace::Left:  column += GetColumnOffset(-1, along); break;
+                default:               column += GetColumnOffset(Size, along); break;
+                }
+                for (int y = 0; y < SECTION_SIZE; y++) {
+                    BlockType type = section.IsUniform() ? section.GetUniformType()
+                                                         : GetBorderBlock(*border, static_cast<BlockFace::Face>(side), along, baseY + y);
+                    if (!(hidingTypes & (1u << static_cast<size_t>(type)))) continue;
+                    uint64_t bit = 1ull << (shift + y);
+                    if (!occupancy[static_cast<size_t>(type)].empty()) occupancy[static_cast<size_t>(type)][column] |= bit;
+                    if (!Block(type).IsTransparent()) opaque[column] |= bit;
+                }
+            }
+        }
+    }
+
+    // Only the words over the occupied y range hold this chunk's blocks
+    const int firstWord = m_minY >> 6;
+    const int lastWord = m_maxY >> 6;
+    std::vector<uint64_t> selfHiding;
+    for (size_t type = 0; type < occupancy.size(); type++) {
+        if (occupancy[type].empty()) continue;
+        const uint64_t* blocks = occupancy[type].data();
+
+        // Faces are hidden by opaque neighbors, and between two blocks of a
+        // transparent type other than a liquid (leaves against leaves)
+        Block block(static_cast<BlockType>(type));
+        const uint64_t* hide = opaque.data();
+        if (block.IsTransparent() && !block.IsLiquid()) {
+            selfHiding.resize(ColumnMaskWords);
+            for (size_t i = 0; i < ColumnMaskWords; i++) {
+                selfHiding[i] = opaque[i] | blocks[i];
+            }
+            hide = selfHiding.data();
+        }
 
-                // Position in world coordinates (not just chunk-local)
-                Vector3 blockPos(chunkOffset.x + x, y, chunkOffset.z + z);
-                const BlockProperties& props = BlockDatabase::GetProperties(block.type);
+        // Past a side with no neighbor the ring is empty and faces are kept
+        for (int x = 0; x < Size; x++) {
+            for (int z = 0; z < Size; z++) {
+                size_t column = GetColumnOffset(x, z);
+                for (int w = firstWord; w <= lastWord; w++) {
+                    size_t i = column + w;
+                    if (blocks[i] == 0) continue;
 
-                for (int face = 0; face < 6; face++) {
-                    if (ShouldRenderFace(x, y, z, static_cast<BlockFace::Face>(face))) {
-                        AddBlockFace(blockPos, static_cast<BlockFace::Face>(face), props.color, block.IsTransparent());
+                    uint64_t hidden[6];
+                    hidden[BlockFace::Front] = hide[GetColumnOffset(x, z + 1) + w];
+                    hidden[BlockFace::Back] = hide[GetColumnOffset(x, z - 1) + w];
+                    hidden[BlockFace::Left] = hide[GetColumnOffset(x - 1, z) + w];
+                    hidden[BlockFace::Right] = hide[GetColumnOffset(x + 1, z) + w];
+                    hidden[BlockFace::Top] = (hide[i] >> 1) | (w + 1 < ColumnWords ? hide[i + 1] << 63 : 0);
+                    hidden[BlockFace::Bottom] = (hide[i] << 1) | (w > 0 ? hide[i - 1] >> 63 : 0);
+                    // Most words lie inside the terrain, hidden on every side
+                    uint64_t hiddenEverywhere = hidden[0] & hidden[1] & hidden[2] & hidden[3] & hidden[4] & hidden[5];
+                    if ((blocks[i] & ~hiddenEverywhere) == 0) continue;
+                    for (int face = 0; face < 6; face++) {
+                        uint64_t bits = blocks[i] & ~hidden[face];
+                        if (bits != 0) {
+                            visible(static_cast<BlockType>(type), static_cast<BlockFace::Face>(face), x, z, w, bits);
+                        }
                     }
                 }
             }
         }
     }
+}
+
+template <typename Shape>
+void BasicChunk<Shape>::GenerateBitmaskMesh() {
+    // GenerateMesh cleared the meshes with their capacity kept, so remeshing
+    // a loaded chunk rarely reallocates
+    std::vector<MeshQuad>* meshes[2] = { &m_quads, &m_transparentQuads };
+    ForEachVisibleFaceWord([&](BlockType type, BlockFace::Face face, int x, int z, int word, uint64_t bits) {
+        std::vector<MeshQuad>& quads = *meshes[Block(type).IsTransparent()];
+        const MeshQuad column = { static_cast<uint8_t>(x), 0, static_cast<uint8_t>(z),
+                                  static_cast<uint8_t>(face), static_cast<uint8_t>(type), 0, 0, 0 };
+        for (; bits != 0; bits &= bits - 1) {
+            quads.push_back(column);
+            quads.back().y = static_cast<uint8_t>(word * 64 + LowestBit(bits));
+        }
+    });
+}
+
+template <typename Shape>
+void BasicChunk<Shape>::GenerateGreedyMesh() {
+    // Visible faces are stored as their block type in one plane-major grid
+    // per face direction. Each plane is then covered with rectangles: grow
+    // along u while the type matches, then along v while the whole row does.
+    const int spanY = m_maxY - m_minY + 1;
+    const int dims[3] = { Size, spanY, Size };
+    // Axis along the normal, then u and v, per face (0 = x, 1 = y, 2 = z)
+    static const int kFaceAxes[6][3] = {
+        { 2, 0, 1 },    // Front
+        { 2, 0, 1 },    // Back
+        { 0, 2, 1 },    // Left
+        { 0, 2, 1 },    // Right
+        { 1, 0, 2 },    // Top
+        { 1, 0, 2 }     // Bottom
+    };
+    const size_t faceCells = static_cast<size_t>(Size) * spanY * Size;
+    std::vector<BlockType> faces(6 * faceCells, BlockType::Air);
+    auto cellIndex = [&](int face, const int (&pos)[3]) {
+        const int* axes = kFaceAxes[face];
+        return face * faceCells +
+               (static_cast<size_t>(pos[axes[0]]) * dims[axes[2]] + pos[axes[2]]) * dims[axes[1]] + pos[axes[1]];
+    };
+
+    ForEachVisibleFaceWord([&](BlockType type, BlockFace::Face face, int x, int z, int word, uint64_t bits) {
+        for (; bits != 0; bits &= bits - 1) {
+            const int pos[3] = { x, word * 64 + LowestBit(bits) - m_minY, z };
+            faces[cellIndex(face, pos)] = type;
+        }
+    });
+
+    for (int face = 0; face < 6; face++) {
+        const int* axes = kFaceAxes[face];
+        const int sizeU = dims[axes[1]];
+        const int sizeV = dims[axes[2]];
+        for (int layer = 0; layer < dims[axes[0]]; layer++) {
+            BlockType* plane = &faces[face * faceCells + static_cast<size_t>(layer) * sizeU * sizeV];
+            for (int v = 0; v < sizeV; v++) {
+                for (int u = 0; u < sizeU; u++) {
+                    BlockType type = plane[v * sizeU + u];
+                    if (type == BlockType::Air) continue;
+
+                    int width = 1;
+                    while (u + width < sizeU && plane[v * sizeU + u + width] == type) {
+                        width++;
+                    }
+                    int height = 1;
+                    for (; v + height < sizeV; height++) {
+                        const BlockType* row = &plane[(v + height) * sizeU + u];
+                        if (std::any_of(row, row + width, [type](BlockType t) { return t != type; })) break;
+                    }
+                    for (int dv = 0; dv < height; dv++) {
+                        std::fill_n(&plane[(v + dv) * sizeU + u], width, BlockType::Air);
+                    }
+
+                    int pos[3];
+                    int size[3];
+                    pos[axes[0]] = layer;
+                    pos[axes[1]] = u;
+                    pos[axes[2]] = v;
+                    pos[1] += m_minY;
+                    size[axes[0]] = 1;
+                    size[axes[1]] = width;
+                    size[axes[2]] = height;
+                    AddQuad(pos[0], pos[1], pos[2], static_cast<BlockFace::Face>(face), type, size[0], size[1], size[2]);
+                }
+            }
+        }
+    }
+}
+
+template <typename Shape>
+size_t BasicChunk<Shape>::CountVisibleFaces(MeshMode mode) const {
+    size_t count = 0;
+    if (mode != MeshMode::PerFace) {
+        ForEachVisibleFaceWord([&count](BlockType, BlockFace::Face, int, int, int, uint64_t bits) {
+            count += CountBits(bits);
+        });
+        return count;
+    }
+
+    if (m_minY > m_maxY) {
+        return 0;
+    }
+    for (int sectionY = m_minY >> SECTION_SHIFT; sectionY <= m_maxY >> SECTION_SHIFT; sectionY++) {
+        for (int sectionX = 0; sectionX < Shape::SectionsXZ; sectionX++) {
+            for (int sectionZ = 0; sectionZ < Shape::SectionsXZ; sectionZ++) {
+                ForEachMeshedBlock(sectionX, sectionY, sectionZ, [&](int x, int y, int z) {
+                    for (int face = 0; face < 6; face++) {
+                        if (ShouldRenderFace(x, y, z, static_cast<BlockFace::Face>(face))) count++;
+                    }
+                });
+            }
+        }
+    }
+    return count;
+}
+
+template <typename Shape>
+void BasicChunk<Shape>::GenerateMesh(MeshMode mode) {
+    m_quads.clear();
+    m_transparentQuads.clear();
+
+    if (mode == MeshMode::Bitmask) {
+        GenerateBitmaskMesh();
+    } else if (mode == MeshMode::Greedy) {
+        if (m_minY <= m_maxY) {
+            GenerateGreedyMesh();
+        }
+    } else {
+        // Only the sections overlapping the occupied y range can hold blocks
+        int firstSection = m_minY <= m_maxY ? m_minY >> SECTION_SHIFT : Shape::SectionsY;
+        int lastSection = m_minY <= m_maxY ? m_maxY >> SECTION_SHIFT : -1;
+
+        for (int sectionY = firstSection; sectionY <= lastSection; sectionY++) {
+            for (int sectionX = 0; sectionX < Shape::SectionsXZ; sectionX++) {
+                for (int sectionZ = 0; sectionZ < Shape::SectionsXZ; sectionZ++) {
+                    ForEachMeshedBlock(sectionX, sectionY, sectionZ,
+                        [&](int x, int y, int z) { AddBlockFaces(x, y, z); });
+                }
+            }
+        }
+    }
 
     m_needsMeshUpdate = false;
     m_needsBufferUpdate = true; // Mesh changed, so buffer needs update
+    m_hasMesh = true;
 }
 
-void Chunk::UpdateBuffer(ID3D11Device* device) {
+template <typename Shape>
+void BasicChunk<Shape>::UpdateBuffer(ID3D11Device* device) {
     if (!m_needsBufferUpdate) {
         return; // Buffer is already up to date
     }
 
-    if (m_vertices.empty()) {
-        m_indexCount = 0;
-        m_vertexBuffer.Reset();
-        m_indexBuffer.Reset();
+    m_gpuBytes = 0;
+
+    // The quad shader adds the chunk's world position from this buffer
+    if (!m_offsetBuffer) {
+        Vector3 chunkOffset = GetWorldPosition();
+        float offset[4] = { chunkOffset.x, chunkOffset.y, chunkOffset.z, 0.0f };
+
+        D3D11_BUFFER_DESC cbDesc = {};
+        cbDesc.Usage = D3D11_USAGE_IMMUTABLE;
+        cbDesc.ByteWidth = sizeof(offset);
+        cbDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+
+        D3D11_SUBRESOURCE_DATA cbData = {};
+        cbData.pSysMem = offset;
+        device->CreateBuffer(&cbDesc, &cbData, m_offsetBuffer.ReleaseAndGetAddressOf());
+    }
+
+    if (m_quads.empty()) {
+        m_quadCount = 0;
+        m_quadBuffer.Reset();
     } else {
-        // Create vertex buffer
+        // Create quad instance buffer
         D3D11_BUFFER_DESC vbDesc = {};
         vbDesc.Usage = D3D11_USAGE_DEFAULT;
-        vbDesc.ByteWidth = static_cast<UINT>(m_vertices.size() * sizeof(Vertex));
+        vbDesc.ByteWidth = static_cast<UINT>(m_quads.size() * sizeof(MeshQuad));
         vbDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 
         D3D11_SUBRESOURCE_DATA vbData = {};
-        vbData.pSysMem = m_vertices.data();
-
-        device->CreateBuffer(&vbDesc, &vbData, m_vertexBuffer.ReleaseAndGetAddressOf());
-
-        // Create index buffer
-        D3D11_BUFFER_DESC ibDesc = {};
-        ibDesc.Usage = D3D11_USAGE_DEFAULT;
-        ibDesc.ByteWidth = static_cast<UINT>(m_indices.size() * sizeof(uint32_t));
-        ibDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+        vbData.pSysMem = m_quads.data();
 
-        D3D11_SUBRESOURCE_DATA ibData = {};
-        ibData.pSysMem = m_indices.data();
+        device->CreateBuffer(&vbDesc, &vbData, m_quadBuffer.ReleaseAndGetAddressOf());
 
-        device->CreateBuffer(&ibDesc, &ibData, m_indexBuffer.ReleaseAndGetAddressOf());
-
-        m_indexCount = static_cast<uint32_t>(m_indices.size());
+        m_quadCount = static_cast<uint32_t>(m_quads.size());
+        m_gpuBytes += vbDesc.ByteWidth;
     }
     
-    // Create transparent vertex buffer
-    if (m_transparentVertices.empty()) {
-        m_transparentIndexCount = 0;
-        m_transparentVertexBuffer.Reset();
-        m_transparentIndexBuffer.Reset();
+    // Create transparent quad instance buffer
+    if (m_transparentQuads.empty()) {
+        m_transparentQuadCount = 0;
+        m_transparentQuadBuffer.Reset();
     } else {
         D3D11_BUFFER_DESC vbDesc = {};
         vbDesc.Usage = D3D11_USAGE_DEFAULT;
-        vbDesc.ByteWidth = static_cast<UINT>(m_transparentVertices.size() * sizeof(Vertex));
+        vbDesc.ByteWidth = static_cast<UINT>(m_transparentQuads.size() * sizeof(MeshQuad));
         vbDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
         
         D3D11_SUBRESOURCE_DATA vbData = {};
-        vbData.pSysMem = m_transparentVertices.data();
-        device->CreateBuffer(&vbDesc, &vbData, m_transparentVertexBuffer.ReleaseAndGetAddressOf());
-
-        D3D11_BUFFER_DESC ibDesc = {};
-        ibDesc.Usage = D3D11_USAGE_DEFAULT;
-        ibDesc.ByteWidth = static_cast<UINT>(m_transparentIndices.size() * sizeof(uint32_t));
-        ibDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+        vbData.pSysMem = m_transparentQuads.data();
+        device->CreateBuffer(&vbDesc, &vbData, m_transparentQuadBuffer.ReleaseAndGetAddressOf());
 
-        D3D11_SUBRESOURCE_DATA ibData = {};
-        ibData.pSysMem = m_transparentIndices.data();
-        device->CreateBuffer(&ibDesc, &ibData, m_transparentIndexBuffer.ReleaseAndGetAddressOf());
-
-        m_transparentIndexCount = static_cast<uint32_t>(m_transparentIndices.size());
+        m_transparentQuadCount = static_cast<uint32_t>(m_transparentQuads.size());
+        m_gpuBytes += vbDesc.ByteWidth;
     }
 
     m_needsBufferUpdate = false; // Buffer is now up to date
 }
 
-void Chunk::Render(ID3D11DeviceContext* context) {
-    if (!m_vertexBuffer || !m_indexBuffer || m_indexCount == 0) {
+template <typename Shape>
+void BasicChunk<Shape>::Render(ID3D11DeviceContext* context) {
+    if (!m_quadBuffer || m_quadCount == 0) {
         return;
     }
 
-    UINT stride = sizeof(Vertex);
+    UINT stride = sizeof(MeshQuad);
     UINT offset = 0;
 
-    context->IASetVertexBuffers(0, 1, m_vertexBuffer.GetAddressOf(), &stride, &offset);
-    context->IASetIndexBuffer(m_indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+    // Six vertices per quad instance, expanded by the quad vertex shader
+    context->IASetVertexBuffers(0, 1, m_quadBuffer.GetAddressOf(), &stride, &offset);
     context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    context->VSSetConstantBuffers(1, 1, m_offsetBuffer.GetAddressOf());
 
-    context->DrawIndexed(m_indexCount, 0, 0);
+    context->DrawInstanced(6, m_quadCount, 0, 0);
 }
 
-void Chunk::RenderTransparent(ID3D11DeviceContext* context) {
-    if (!m_transparentVertexBuffer || !m_transparentIndexBuffer || m_transparentIndexCount == 0) {
+template <typename Shape>
+void BasicChunk<Shape>::RenderTransparent(ID3D11DeviceContext* context) {
+    if (!m_transparentQuadBuffer || m_transparentQuadCount == 0) {
         return;
     }
 
-    UINT stride = sizeof(Vertex);
+    UINT stride = sizeof(MeshQuad);
     UINT offset = 0;
 
-    context->IASetVertexBuffers(0, 1, m_transparentVertexBuffer.GetAddressOf(), &stride, &offset);
-    context->IASetIndexBuffer(m_transparentIndexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+    context->IASetVertexBuffers(0, 1, m_transparentQuadBuffer.GetAddressOf(), &stride, &offset);
     context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    context->VSSetConstantBuffers(1, 1, m_offsetBuffer.GetAddressOf());
 
-    context->DrawIndexed(m_transparentIndexCount, 0, 0);
+    context->DrawInstanced(6, m_transparentQuadCount, 0, 0);
 }
+
+template class BasicChunk<ChunkShape16>;
+template class BasicChunk<ChunkShape32>;
+template class BasicChunk<ChunkShapeCubic32>;
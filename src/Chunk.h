@@ -1,15 +1,64 @@
 #pragma once
 #include "Block.h"
+#include "BlockDatabase.h"
+#include "BlockEdits.h"
+#include "ChunkSection.h"
+#include "MemoryTracker.h"
 #include "MathUtils.h"
 #include <d3d11.h>
 #include <wrl/client.h>
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <memory>
 #include <vector>
 #include <cstdint>
 
 using Microsoft::WRL::ComPtr;
 
-const int CHUNK_SIZE = 16;
-const int CHUNK_HEIGHT = 256;
+// Vertical extent of the world; chunks shorter than this are stacked
+const int WORLD_HEIGHT = 256;
+
+constexpr int ChunkShapeLog2(int value) {
+    return value > 1 ? 1 + ChunkShapeLog2(value / 2) : 0;
+}
+
+// Compile-time chunk dimensions. Sizes are powers of two so world to local
+// coordinates reduce to shifts and masks, and whole multiples of the section
+// size so a chunk is a grid of sections.
+template <int SizeXZ, int SizeY>
+struct ChunkShape {
+    static constexpr int Size = SizeXZ;
+    static constexpr int Height = SizeY;
+    static constexpr int SizeShift = ChunkShapeLog2(SizeXZ);
+    static constexpr int SizeMask = SizeXZ - 1;
+    static constexpr int HeightShift = ChunkShapeLog2(SizeY);
+    static constexpr int HeightMask = SizeY - 1;
+
+    static constexpr int SectionsXZ = SizeXZ / SECTION_SIZE;
+    static constexpr int SectionsY = SizeY / SECTION_SIZE;
+    static constexpr int SectionCount = SectionsXZ * SectionsY * SectionsXZ;
+
+    static_assert((1 << SizeShift) == SizeXZ && (1 << HeightShift) == SizeY, "chunk sizes must be powers of two");
+    static_assert(SizeXZ >= SECTION_SIZE && SizeY >= SECTION_SIZE, "chunks hold whole sections");
+    static_assert(SizeY <= WORLD_HEIGHT, "chunk taller than the world");
+    static_assert(SizeXZ <= 256 && SizeY <= 256, "mesh quads store block positions in bytes");
+};
+
+using ChunkShape16 = ChunkShape<16, WORLD_HEIGHT>;
+using ChunkShape32 = ChunkShape<32, WORLD_HEIGHT>;
+using ChunkShapeCubic32 = ChunkShape<32, 32>;
+
+// The world streams full-height columns of the configured width
+#if RTXBLOCKS_CHUNK_SIZE == 32
+using DefaultChunkShape = ChunkShape32;
+#else
+using DefaultChunkShape = ChunkShape16;
+#endif
+
+const int CHUNK_SIZE = DefaultChunkShape::Size;
+const int CHUNK_HEIGHT = DefaultChunkShape::Height;
+const int SECTIONS_PER_CHUNK = DefaultChunkShape::SectionCount;
 
 struct Vertex {
     Vector3 position;
@@ -18,64 +67,363 @@ struct Vertex {
     Vector2 texCoord;
 };
 
-class Chunk {
+// One face of a chunk mesh in 8 bytes, where its 4 vertices and 6 indices
+// take 216: the chunk-local block, the face, the block type and the face's
+// extent in blocks minus 1 along each axis (0 for a single face, more for
+// greedy rectangles). The D3D11 renderer draws quads as instances that its
+// vertex shader expands; the DX12 one gets vertices from AppendSolidMesh.
+struct MeshQuad {
+    uint8_t x, y, z;
+    uint8_t face;
+    uint8_t type;
+    uint8_t sizeX, sizeY, sizeZ;
+};
+static_assert(sizeof(MeshQuad) == 8, "the quad input layout reads two 4-byte elements");
+
+// How GenerateMesh turns visible block faces into quads
+enum class MeshMode : uint8_t {
+    PerFace,    // one quad per visible face
+    Bitmask,    // the same quads, with faces found a column of blocks at a time
+    Greedy      // coplanar neighboring faces of one type merged into rectangles
+};
+
+inline const char* GetMeshModeName(MeshMode mode) {
+    switch (mode) {
+    case MeshMode::Bitmask: return "bitmask";
+    case MeshMode::Greedy: return "greedy";
+    default: return "per-face";
+    }
+}
+
+// Chunk of Shape::Size x Shape::Height x Shape::Size blocks. Column shapes
+// span the whole world height; shorter (cubic) shapes are stacked by chunkY.
+template <typename Shape>
+class BasicChunk {
 public:
-    Chunk(int chunkX, int chunkZ);
-    ~Chunk();
+    static constexpr int Size = Shape::Size;
+    static constexpr int Height = Shape::Height;
+    static constexpr int SizeShift = Shape::SizeShift;
+    static constexpr int SizeMask = Shape::SizeMask;
+    static constexpr int SectionCount = Shape::SectionCount;
+    using SectionArray = std::array<ChunkSection, Shape::SectionCount>;
+
+    BasicChunk(int chunkX, int chunkZ, int chunkY = 0);
+    ~BasicChunk();
+
+    // Pool support: Retire frees block data, mesh storage and GPU buffers,
+    // Reset readies a retired chunk for new coordinates
+    void Retire();
+    void Reset(int chunkX, int chunkZ, int chunkY = 0);
 
     void SetBlock(int x, int y, int z, BlockType type);
     Block GetBlock(int x, int y, int z) const;
+    // No bounds check: for callers that already clipped to the chunk
+    BlockType GetBlockType(int x, int y, int z) const {
+        return GetSectionAt(x, y, z).Get(x & SECTION_MASK, y & SECTION_MASK, z & SECTION_MASK);
+    }
+
+    // Only stored for block types that declare state in BlockDatabase;
+    // SetBlockState returns whether the stored state changed
+    BlockState GetBlockState(int x, int y, int z) const;
+    bool SetBlockState(int x, int y, int z, BlockState state);
 
     bool IsBlockInBounds(int x, int y, int z) const;
 
-    void GenerateMesh();
+    // Bulk edits over the chunk-local box min..max (inclusive, clipped to
+    // the chunk), written straight into section storage. Sections the box
+    // covers whole are filled as one; the extents are rebuilt and one remesh
+    // is marked at the end. Each returns whether any block changed.
+    bool FillBox(int minX, int minY, int minZ, int maxX, int maxY, int maxZ, BlockType type);
+    bool ReplaceInBox(int minX, int minY, int minZ, int maxX, int maxY, int maxZ, BlockType from, BlockType to);
+    // The blocks within radius of the center, which may lie outside the chunk
+    bool FillSphere(int centerX, int centerY, int centerZ, int radius, BlockType type);
+    // The part of the buffer over this chunk, with its corner at the
+    // chunk-local origin; air in the buffer is skipped if skipAir
+    bool Paste(const BlockBuffer& buffer, int originX, int originY, int originZ, bool skipAir);
+    // typeAt(x, y, z, oldType) gives each block's new type
+    template <typename Fn>
+    bool EditBox(int minX, int minY, int minZ, int maxX, int maxY, int maxZ, Fn&& typeAt) {
+        if (!ClipBox(minX, minY, minZ, maxX, maxY, maxZ)) return false;
+        BulkEdit edit;
+        ForEachSectionInBox(minX, minY, minZ, maxX, maxY, maxZ,
+            [&](int index, int baseY, int x0, int y0, int z0, int x1, int y1, int z1) {
+                ChunkSection& section = m_sections[index];
+                int baseX = (index / Shape::SectionsXZ % Shape::SectionsXZ) * SECTION_SIZE;
+                int baseZ = (index % Shape::SectionsXZ) * SECTION_SIZE;
+                // New types first, so the storage makes room for all of them at once
+                BlockType newTypes[SECTION_VOLUME];
+                uint32_t writtenTypes = 0;
+                int count = 0;
+                for (int x = x0; x <= x1; x++) {
+                    for (int y = y0; y <= y1; y++) {
+                        for (int z = z0; z <= z1; z++) {
+                            BlockType oldType = section.Get(x, y, z);
+                            BlockType newType = typeAt(baseX + x, baseY + y, baseZ + z, oldType);
+                            newTypes[count++] = newType;
+                            if (newType != oldType) writtenTypes |= ChunkSection::GetTypeBit(newType);
+                        }
+                    }
+                }
+                if (writtenTypes == 0) return;
+
+                count = 0;
+                for (int x = x0; x <= x1; x++) {
+                    for (int y = y0; y <= y1; y++) {
+                        for (int z = z0; z <= z1; z++) {
+                            BlockType oldType = section.Get(x, y, z);
+                            BlockType newType = newTypes[count++];
+                            if (newType != oldType) {
+                                WriteBlock(edit, index, writtenTypes, x, y, z, oldType, newType);
+                            }
+                        }
+                    }
+                }
+                section.EndWrites();
+            });
+        return FinishBulkEdit(edit);
+    }
+
+    void GenerateMesh(MeshMode mode = MeshMode::PerFace);
+    // Just the face finding of a mode, without building geometry: per-face
+    // tests each face with ShouldRenderFace, the others use bitmasks
+    size_t CountVisibleFaces(MeshMode mode) const;
     void UpdateBuffer(ID3D11Device* device);
 
     void Render(ID3D11DeviceContext* context);
     void RenderTransparent(ID3D11DeviceContext* context);
 
     bool NeedsMeshUpdate() const { return m_needsMeshUpdate; }
-    void MarkForMeshUpdate() { m_needsMeshUpdate = true; m_needsBufferUpdate = true; }
+    void MarkForMeshUpdate() { m_needsMeshUpdate = true; m_needsBufferUpdate = true; m_revision++; }
     bool NeedsBufferUpdate() const { return m_needsBufferUpdate; }
+    // Bumped by every change that needs a remesh, so a mesh built from an
+    // older snapshot can be recognized as stale, and by BumpRevision for
+    // changes that don't (block states), so published copies are refreshed
+    uint32_t GetRevision() const { return m_revision; }
+    void BumpRevision() { m_revision++; }
+
+    // Off-thread meshing: CopyBlocksFrom makes this chunk a snapshot of
+    // another's blocks (sections are shared copy-on-write), and SwapMesh
+    // installs the snapshot's finished mesh here in one step
+    void CopyBlocksFrom(const BasicChunk& other);
+    void SwapMesh(BasicChunk& meshed);
+    // Gives a snapshot the neighbor's edge sections on one side (Front, Back,
+    // Left or Right), shared the same way, so faces on that border are culled
+    // against the neighbor's blocks. Without a neighbor (null, or never
+    // copied) faces on the border are kept.
+    void CopyBorderFrom(BlockFace::Face side, const BasicChunk* neighbor);
 
     int GetChunkX() const { return m_chunkX; }
     int GetChunkZ() const { return m_chunkZ; }
+    int GetChunkY() const { return m_chunkY; }
 
-    uint32_t GetSolidIndexCount() const { return m_indexCount; }
-    uint32_t GetTransparentIndexCount() const { return m_transparentIndexCount; }
-    const std::vector<Vertex>& GetSolidVertices() const { return m_vertices; }
-    const std::vector<uint32_t>& GetSolidIndices() const { return m_indices; }
-    const std::vector<Vertex>& GetTransparentVertices() const { return m_transparentVertices; }
-    const std::vector<uint32_t>& GetTransparentIndices() const { return m_transparentIndices; }
+    // Indices the uploaded quads stand for, 6 per quad
+    uint32_t GetSolidIndexCount() const { return m_quadCount * 6; }
+    uint32_t GetTransparentIndexCount() const { return m_transparentQuadCount * 6; }
+    const std::vector<MeshQuad>& GetSolidQuads() const { return m_quads; }
+    const std::vector<MeshQuad>& GetTransparentQuads() const { return m_transparentQuads; }
+    // Expand the quads into world-space vertices and indices appended to
+    // the caller's, the indices numbered on from the vertices already there
+    void AppendSolidMesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) const;
+    void AppendTransparentMesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) const;
 
     Vector3 GetWorldPosition() const {
-        return Vector3(m_chunkX * CHUNK_SIZE, 0, m_chunkZ * CHUNK_SIZE);
+        return Vector3(static_cast<float>(m_chunkX * Size), static_cast<float>(m_chunkY * Height),
+                       static_cast<float>(m_chunkZ * Size));
     }
 
     bool IsEmpty() const { return m_isEmpty; }
+    // Set by the world on player and bulk edits (not by terrain generation),
+    // so the cold cache knows which chunks it cannot regenerate
+    bool IsModified() const { return m_isModified; }
+    void SetModified(bool isModified) { m_isModified = isModified; }
+    // Meshed at least once since loading (the mesh may be out of date)
+    bool HasMesh() const { return m_hasMesh; }
+
+    // Memory accounting: ReportMemory pushes the change since the last report
+    // to the tracker, WithdrawMemory takes back everything reported so far
+    void ReportMemory(MemoryTracker& tracker);
+    void WithdrawMemory(MemoryTracker& tracker);
+    size_t GetCpuMeshMemoryUsage() const;
+    size_t GetGpuMemoryUsage() const { return m_gpuBytes; }
+
+    // Frees the CPU mesh copy once it lives on the GPU (regenerated on remesh)
+    void ReleaseCpuMesh();
+    bool HasCpuMesh() const { return !m_quads.empty() || !m_transparentQuads.empty(); }
+
+    uint64_t GetLastVisibleFrame() const { return m_lastVisibleFrame; }
+    void SetLastVisibleFrame(uint64_t frame) { m_lastVisibleFrame = frame; }
+
+    // Highest solid block in a column (chunk-local), or -1 if the column has none
+    int GetHeight(int x, int z) const { return m_heightmap[x][z]; }
+    // Vertical range holding any non-air block (min > max when empty)
+    int GetMinY() const { return m_minY; }
+    int GetMaxY() const { return m_maxY; }
+    size_t GetBlockMemoryUsage() const;
+
+    // Sections are ordered y, then x, then z, so for a single-section-wide
+    // column the index is just the section's height
+    static int GetSectionIndex(int sectionX, int sectionY, int sectionZ) {
+        return (sectionY * Shape::SectionsXZ + sectionX) * Shape::SectionsXZ + sectionZ;
+    }
+    const ChunkSection& GetSection(int index) const { return m_sections[index]; }
+    void CompactSections();
+    // Replaces all blocks at once (e.g. restored from ChunkCache)
+    void LoadSections(const SectionArray& sections);
 
 private:
-    void AddBlockFace(const Vector3& pos, BlockFace::Face face, const Vector4& color, bool isTransparent);
+    // The corners of a face of a block at the origin; size stretches the
+    // unit face into a rectangle (1 along the normal)
+    static void GetFaceCorners(BlockFace::Face face, const Vector4& color, const Vector3& size, Vertex (&corners)[4]);
+    static void AppendFace(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices,
+                           const Vertex (&corners)[4], const Vector3& pos);
+    void AppendQuads(const std::vector<MeshQuad>& quads, std::vector<Vertex>& vertices,
+                     std::vector<uint32_t>& indices) const;
+    // Adds a quad to the solid or transparent mesh; sizes are in blocks
+    void AddQuad(int x, int y, int z, BlockFace::Face face, BlockType type, int sizeX = 1, int sizeY = 1, int sizeZ = 1);
     bool ShouldRenderFace(int x, int y, int z, BlockFace::Face face) const;
+    // Edge sections of the horizontal neighbors, indexed by side and then
+    // (sectionY, section along the side); only meshing snapshots have them
+    struct NeighborBorder {
+        bool loaded = false;
+        std::array<ChunkSection, Shape::SectionsY * Shape::SectionsXZ> sections;
+    };
+    const NeighborBorder* GetBorder(BlockFace::Face side) const {
+        return m_borders && side <= BlockFace::Right && (*m_borders)[side].loaded ? &(*m_borders)[side] : nullptr;
+    }
+    // The neighbor's block next to this chunk's block at (along, y) on a side,
+    // along being z on the Left and Right sides and x on the Front and Back
+    static BlockType GetBorderBlock(const NeighborBorder& border, BlockFace::Face side, int along, int y);
+    void ClearBorders();
+    void AddBlockFaces(int x, int y, int z);
+    bool IsSectionSolid(int sectionX, int sectionY, int sectionZ) const;
+    // visit(x, y, z) for each block of the section that may show a face
+    template <typename Fn>
+    void ForEachMeshedBlock(int sectionX, int sectionY, int sectionZ, Fn&& visit) const;
+
+    // Block columns as bitmasks, bit i of word w standing for y = w * 64 + i,
+    // for x and z from -1 to Size: the chunk padded with its neighbors' border
+    static constexpr int ColumnWords = (Shape::Height + 63) / 64;
+    static constexpr int PaddedSize = Shape::Size + 2;
+    static constexpr size_t ColumnMaskWords = static_cast<size_t>(PaddedSize) * PaddedSize * ColumnWords;
+    static size_t GetColumnOffset(int x, int z) { return (static_cast<size_t>(x + 1) * PaddedSize + (z + 1)) * ColumnWords; }
+    // visible(type, face, x, z, word, bits) for each column word in which
+    // blocks of a type show a face. Finds the same faces as ShouldRenderFace
+    // from occupancy and opacity masks shifted against each other.
+    template <typename Fn>
+    void ForEachVisibleFaceWord(Fn&& visible) const;
+    void GenerateBitmaskMesh();
+    void GenerateGreedyMesh();
+    ChunkSection& GetSectionAt(int x, int y, int z) {
+        return m_sections[GetSectionIndex(x >> SECTION_SHIFT, y >> SECTION_SHIFT, z >> SECTION_SHIFT)];
+    }
+    const ChunkSection& GetSectionAt(int x, int y, int z) const {
+        return m_sections[GetSectionIndex(x >> SECTION_SHIFT, y >> SECTION_SHIFT, z >> SECTION_SHIFT)];
+    }
+    void UpdateExtents(int x, int y, int z, BlockType oldType, BlockType newType);
+    void ResetExtents();
+    void RebuildExtents();
+    // False if nothing of the box is inside the chunk
+    bool ClipBox(int& minX, int& minY, int& minZ, int& maxX, int& maxY, int& maxZ) const;
+    // What a bulk edit changed: the sections written, and the columns whose
+    // highest solid block was removed, to be searched again at the end
+    struct BulkEdit {
+        std::bitset<Shape::SectionCount> sections;
+        std::bitset<Shape::Size * Shape::Size> staleHeights;
+    };
+    // fn(index, baseY, x0, y0, z0, x1, y1, z1) for each section the clipped
+    // box overlaps, with the section-local range it covers
+    template <typename Fn>
+    void ForEachSectionInBox(int minX, int minY, int minZ, int maxX, int maxY, int maxZ, Fn&& fn) {
+        for (int sectionY = minY >> SECTION_SHIFT; sectionY <= maxY >> SECTION_SHIFT; sectionY++) {
+            for (int sectionX = minX >> SECTION_SHIFT; sectionX <= maxX >> SECTION_SHIFT; sectionX++) {
+                for (int sectionZ = minZ >> SECTION_SHIFT; sectionZ <= maxZ >> SECTION_SHIFT; sectionZ++) {
+                    int baseX = sectionX * SECTION_SIZE;
+                    int baseY = sectionY * SECTION_SIZE;
+                    int baseZ = sectionZ * SECTION_SIZE;
+                    fn(GetSectionIndex(sectionX, sectionY, sectionZ), baseY,
+                       std::max(minX - baseX, 0), std::max(minY - baseY, 0), std::max(minZ - baseZ, 0),
+                       std::min(maxX - baseX, SECTION_MASK), std::min(maxY - baseY, SECTION_MASK),
+                       std::min(maxZ - baseZ, SECTION_MASK));
+                }
+            }
+        }
+    }
+    void CountLayerChange(int y, BlockType oldType, BlockType newType) {
+        if ((oldType == BlockType::Air) != (newType == BlockType::Air)) {
+            m_layerBlockCounts[y] += newType == BlockType::Air ? -1 : 1;
+        }
+    }
+    void UpdateBulkHeight(BulkEdit& edit, int x, int y, int z, bool isSolid) {
+        int16_t& height = m_heightmap[x][z];
+        if (isSolid && y > height) {
+            height = static_cast<int16_t>(y);
+        } else if (!isSolid && y == height) {
+            edit.staleHeights.set(x * Size + z);
+        }
+    }
+    // A changed block of a bulk edit (section-local x, y, z), written with
+    // ChunkSection::Write; the section's first write begins writing all of
+    // writtenTypes. EndWrites is left to the caller, once per section.
+    void WriteBlock(BulkEdit& edit, int index, uint32_t writtenTypes, int x, int y, int z, BlockType oldType,
+                    BlockType newType) {
+        ChunkSection& section = m_sections[index];
+        if (!edit.sections[index]) {
+            section.BeginWrites(writtenTypes);
+            edit.sections.set(index);
+        }
+        section.Write(x, y, z, newType);
+        int chunkY = (index / (Shape::SectionsXZ * Shape::SectionsXZ)) * SECTION_SIZE + y;
+        CountLayerChange(chunkY, oldType, newType);
+        UpdateBulkHeight(edit, (index / Shape::SectionsXZ % Shape::SectionsXZ) * SECTION_SIZE + x, chunkY,
+                         (index % Shape::SectionsXZ) * SECTION_SIZE + z, BlockDatabase::IsSolid(newType));
+    }
+    // Fills a whole section, keeping the layer counts and heights; false
+    // (and nothing done) if blocks already of the type hold state, which
+    // Fill would drop
+    bool FillSection(BulkEdit& edit, int index, int baseY, BlockType type);
+    // Brings the extents up to date, collapses the written sections and
+    // marks the remesh; false if nothing was written
+    bool FinishBulkEdit(const BulkEdit& edit);
+    void RebuildHeight(int x, int z);
 
-    int m_chunkX, m_chunkZ;
-    Block m_blocks[CHUNK_SIZE][CHUNK_HEIGHT][CHUNK_SIZE];
+    int m_chunkX, m_chunkZ, m_chunkY;
+    SectionArray m_sections;
+    std::unique_ptr<std::array<NeighborBorder, 4>> m_borders;
+
+    // Kept up to date by SetBlock
+    int16_t m_heightmap[Shape::Size][Shape::Size];
+    uint16_t m_layerBlockCounts[Shape::Height];
+    int m_minY;
+    int m_maxY;
     
     // Solid geometry
-    std::vector<Vertex> m_vertices;
-    std::vector<uint32_t> m_indices;
-    ComPtr<ID3D11Buffer> m_vertexBuffer;
-    ComPtr<ID3D11Buffer> m_indexBuffer;
-    uint32_t m_indexCount;
+    std::vector<MeshQuad> m_quads;
+    ComPtr<ID3D11Buffer> m_quadBuffer;
+    uint32_t m_quadCount;
 
     // Transparent geometry
-    std::vector<Vertex> m_transparentVertices;
-    std::vector<uint32_t> m_transparentIndices;
-    ComPtr<ID3D11Buffer> m_transparentVertexBuffer;
-    ComPtr<ID3D11Buffer> m_transparentIndexBuffer;
-    uint32_t m_transparentIndexCount;
+    std::vector<MeshQuad> m_transparentQuads;
+    ComPtr<ID3D11Buffer> m_transparentQuadBuffer;
+    uint32_t m_transparentQuadCount;
+
+    // The chunk's world position for the quad vertex shader
+    ComPtr<ID3D11Buffer> m_offsetBuffer;
+
+    size_t m_gpuBytes;
+    std::array<size_t, 3> m_reportedMemory; // BlockData, CpuMesh, GpuMesh
+    uint64_t m_lastVisibleFrame;
 
+    uint32_t m_revision;
     bool m_needsMeshUpdate;
     bool m_needsBufferUpdate;
     bool m_isEmpty;
+    bool m_hasMesh;
+    bool m_isModified;
 };
+
+// Explicitly instantiated in Chunk.cpp
+extern template class BasicChunk<ChunkShape16>;
+extern template class BasicChunk<ChunkShape32>;
+extern template class BasicChunk<ChunkShapeCubic32>;
+
+using Chunk = BasicChunk<DefaultChunkShape>;
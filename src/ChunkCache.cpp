@@ -0,0 +1,189 @@
+#include "ChunkCache.h"
+#include <chrono>
+
+namespace {
+    using Clock = std::chrono::high_resolution_clock;
+
+    enum SectionTag : uint8_t {
+        Uniform = 0,
+        Runs = 1
+    };
+
+    double ElapsedMs(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+}
+
+ChunkCache::ChunkCache(size_t byteBudget) {
+    m_stats.byteBudget = byteBudget;
+}
+
+void ChunkCache::Compress(const Chunk& chunk, std::vector<uint8_t>& out) {
+    // Per section: a uniform tag and type, or (type, 16-bit count) runs in
+    // column order, since terrain is made of long vertical runs. Then the
+    // section's block states as (16-bit local index, state) pairs.
+    out.clear();
+    auto pushUint16 = [&out](uint32_t value) {
+        out.push_back(static_cast<uint8_t>(value & 0xFF));
+        out.push_back(static_cast<uint8_t>(value >> 8));
+    };
+
+    for (int sectionIndex = 0; sectionIndex < Chunk::SectionCount; sectionIndex++) {
+        const ChunkSection& section = chunk.GetSection(sectionIndex);
+        if (section.IsUniform()) {
+            out.push_back(SectionTag::Uniform);
+            out.push_back(static_cast<uint8_t>(section.GetUniformType()));
+        } else {
+            out.push_back(SectionTag::Runs);
+            BlockType runType = section.Get(0, 0, 0);
+            uint32_t runLength = 0;
+            for (int x = 0; x < SECTION_SIZE; x++) {
+                for (int z = 0; z < SECTION_SIZE; z++) {
+                    for (int y = 0; y < SECTION_SIZE; y++) {
+                        BlockType type = section.Get(x, y, z);
+                        if (type != runType) {
+                            out.push_back(static_cast<uint8_t>(runType));
+                            pushUint16(runLength);
+                            runType = type;
+                            runLength = 0;
+                        }
+                        runLength++;
+                    }
+                }
+            }
+            out.push_back(static_cast<uint8_t>(runType));
+            pushUint16(runLength);
+        }
+
+        pushUint16(static_cast<uint32_t>(section.GetStateCount()));
+        section.ForEachState([&](int x, int y, int z, BlockState state) {
+            pushUint16(static_cast<uint32_t>((x << 8) | (y << 4) | z));
+            out.push_back(state);
+        });
+    }
+}
+
+bool ChunkCache::Decompress(const std::vector<uint8_t>& data, Chunk& chunk) {
+    Chunk::SectionArray sections;
+    size_t pos = 0;
+    auto readUint16 = [&data, &pos]() {
+        int value = data[pos] | (data[pos + 1] << 8);
+        pos += 2;
+        return value;
+    };
+
+    for (int sectionIndex = 0; sectionIndex < Chunk::SectionCount; sectionIndex++) {
+        if (pos + 2 > data.size()) return false;
+        uint8_t tag = data[pos++];
+        ChunkSection& section = sections[sectionIndex];
+
+        if (tag == SectionTag::Uniform) {
+            section.Fill(static_cast<BlockType>(data[pos++]));
+        } else {
+            int index = 0;
+            while (index < SECTION_VOLUME) {
+                if (pos + 3 > data.size()) return false;
+                BlockType type = static_cast<BlockType>(data[pos++]);
+                int runLength = readUint16();
+
+                for (int i = 0; i < runLength && index < SECTION_VOLUME; i++, index++) {
+                    int x = index / (SECTION_SIZE * SECTION_SIZE);
+                    int z = (index / SECTION_SIZE) % SECTION_SIZE;
+                    int y = index % SECTION_SIZE;
+                    section.Set(x, y, z, type);
+                }
+            }
+        }
+
+        if (pos + 2 > data.size()) return false;
+        int stateCount = readUint16();
+        for (int i = 0; i < stateCount; i++) {
+            if (pos + 3 > data.size()) return false;
+            int key = readUint16();
+            section.SetState(key >> 8, (key >> 4) & 15, key & 15, data[pos++]);
+        }
+    }
+
+    chunk.LoadSections(sections);
+    return true;
+}
+
+void ChunkCache::Store(const Chunk& chunk) {
+    Key key(chunk.GetChunkX(), chunk.GetChunkZ());
+    auto existing = m_entries.find(key);
+    if (existing != m_entries.end()) {
+        Remove(existing);
+    }
+
+    auto start = Clock::now();
+    Entry entry;
+    Compress(chunk, entry.data);
+    entry.data.shrink_to_fit();
+    m_stats.compressMs += ElapsedMs(start);
+    m_stats.stores++;
+
+    entry.modified = chunk.IsModified();
+    if (entry.modified) {
+        m_stats.modifiedCount++;
+        m_stats.modifiedByteCount += entry.data.size();
+    } else {
+        m_lru.push_front(key);
+        entry.lruPosition = m_lru.begin();
+    }
+    m_stats.byteCount += entry.data.size();
+    m_entries.emplace(key, std::move(entry));
+
+    EvictToBudget();
+}
+
+bool ChunkCache::Load(Chunk& chunk) {
+    auto it = m_entries.find(Key(chunk.GetChunkX(), chunk.GetChunkZ()));
+    if (it == m_entries.end()) {
+        m_stats.misses++;
+        return false;
+    }
+
+    auto start = Clock::now();
+    bool loaded = Decompress(it->second.data, chunk);
+    m_stats.decompressMs += ElapsedMs(start);
+    // A failed decode leaves generation to redo the chunk, edits lost
+    chunk.SetModified(loaded && it->second.modified);
+    Remove(it);
+
+    if (!loaded) {
+        m_stats.misses++;
+        return false;
+    }
+    m_stats.hits++;
+    return true;
+}
+
+void ChunkCache::SetByteBudget(size_t byteBudget) {
+    m_stats.byteBudget = byteBudget;
+    EvictToBudget();
+}
+
+void ChunkCache::Remove(std::map<Key, Entry>::iterator it) {
+    m_stats.byteCount -= it->second.data.size();
+    if (it->second.modified) {
+        m_stats.modifiedCount--;
+        m_stats.modifiedByteCount -= it->second.data.size();
+    } else {
+        m_lru.erase(it->second.lruPosition);
+    }
+    m_entries.erase(it);
+}
+
+void ChunkCache::EvictToBudget() {
+    // Modified entries aren't in m_lru, so only regenerable chunks go
+    while (m_stats.byteCount > m_stats.byteBudget && !m_lru.empty()) {
+        Remove(m_entries.find(m_lru.back()));
+        m_stats.evictions++;
+    }
+}
+
+ChunkCache::Stats ChunkCache::GetStats() const {
+    Stats stats = m_stats;
+    stats.entryCount = m_entries.size();
+    return stats;
+}
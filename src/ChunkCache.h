@@ -0,0 +1,61 @@
+#pragma once
+#include "Chunk.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <utility>
+#include <vector>
+
+// Second tier for chunks that leave the load radius. Their blocks are kept
+// run-length encoded in memory, so reloading one (with any player edits)
+// only needs a decode instead of terrain generation. Over the byte budget
+// the least recently stored unmodified chunks are dropped, as they can be
+// generated again; modified chunks are never dropped and may keep the
+// cache over its budget.
+class ChunkCache {
+public:
+    struct Stats {
+        uint64_t stores = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        size_t entryCount = 0;
+        size_t byteCount = 0;
+        size_t modifiedCount = 0;
+        size_t modifiedByteCount = 0;
+        size_t byteBudget = 0;
+        double compressMs = 0.0;
+        double decompressMs = 0.0;
+    };
+
+    explicit ChunkCache(size_t byteBudget);
+
+    void Store(const Chunk& chunk);
+    // Restores the chunk at chunk's coordinates, modified flag included, and
+    // removes it from the cache
+    bool Load(Chunk& chunk);
+
+    void SetByteBudget(size_t byteBudget);
+    Stats GetStats() const;
+
+private:
+    using Key = std::pair<int, int>;
+
+    struct Entry {
+        std::vector<uint8_t> data;
+        bool modified = false;
+        // Only unmodified entries are in m_lru
+        std::list<Key>::iterator lruPosition;
+    };
+
+    static void Compress(const Chunk& chunk, std::vector<uint8_t>& out);
+    static bool Decompress(const std::vector<uint8_t>& data, Chunk& chunk);
+
+    void Remove(std::map<Key, Entry>::iterator it);
+    void EvictToBudget();
+
+    std::map<Key, Entry> m_entries;
+    std::list<Key> m_lru; // Unmodified entries, most recently stored first
+    Stats m_stats;
+};
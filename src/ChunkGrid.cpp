@@ -0,0 +1,115 @@
+#include "ChunkGrid.h"
+
+ChunkGrid::ChunkGrid(int windowRadius)
+    : m_shift(0)
+    , m_size(0)
+    , m_mask(0)
+    , m_centerX(0)
+    , m_centerZ(0)
+    , m_originX(0)
+    , m_originZ(0)
+    , m_count(0) {
+    SetWindowRadius(windowRadius);
+}
+
+Chunk* ChunkGrid::FindOverflow(int chunkX, int chunkZ) const {
+    auto it = m_overflow.find(GetKey(chunkX, chunkZ));
+    return it != m_overflow.end() ? it->second.get() : nullptr;
+}
+
+void ChunkGrid::Place(ChunkPool::Handle chunk) {
+    int chunkX = chunk->GetChunkX();
+    int chunkZ = chunk->GetChunkZ();
+    if (InWindow(chunkX, chunkZ)) {
+        m_slots[GetSlotIndex(chunkX, chunkZ)] = std::move(chunk);
+    } else {
+        m_overflow[GetKey(chunkX, chunkZ)] = std::move(chunk);
+    }
+}
+
+Chunk* ChunkGrid::Insert(ChunkPool::Handle chunk) {
+    Chunk* chunkPtr = chunk.get();
+    Place(std::move(chunk));
+    m_count++;
+    return chunkPtr;
+}
+
+ChunkPool::Handle ChunkGrid::Remove(int chunkX, int chunkZ) {
+    ChunkPool::Handle chunk;
+    if (InWindow(chunkX, chunkZ)) {
+        chunk = std::move(m_slots[GetSlotIndex(chunkX, chunkZ)]);
+    } else {
+        auto it = m_overflow.find(GetKey(chunkX, chunkZ));
+        if (it != m_overflow.end()) {
+            chunk = std::move(it->second);
+            m_overflow.erase(it);
+        }
+    }
+
+    if (chunk) {
+        m_count--;
+    }
+    return chunk;
+}
+
+void ChunkGrid::AdmitOverflow() {
+    for (auto it = m_overflow.begin(); it != m_overflow.end();) {
+        if (InWindow(it->second->GetChunkX(), it->second->GetChunkZ())) {
+            ChunkPool::Handle chunk = std::move(it->second);
+            it = m_overflow.erase(it);
+            Place(std::move(chunk));
+        } else {
+            ++it;
+        }
+    }
+}
+
+void ChunkGrid::Recenter(int centerX, int centerZ) {
+    if (centerX == m_centerX && centerZ == m_centerZ) {
+        return;
+    }
+
+    m_centerX = centerX;
+    m_centerZ = centerZ;
+    m_originX = centerX - m_size / 2;
+    m_originZ = centerZ - m_size / 2;
+
+    // Slots are addressed by absolute coordinates, so chunks still inside
+    // the window stay put; only those past the trailing edge move out
+    for (auto& slot : m_slots) {
+        if (slot && !InWindow(slot->GetChunkX(), slot->GetChunkZ())) {
+            uint64_t key = GetKey(slot->GetChunkX(), slot->GetChunkZ());
+            m_overflow[key] = std::move(slot);
+        }
+    }
+
+    AdmitOverflow();
+}
+
+void ChunkGrid::SetWindowRadius(int radius) {
+    int shift = 0;
+    while ((1 << shift) < 2 * radius + 1) {
+        shift++;
+    }
+    if (shift == m_shift && m_size != 0) {
+        return;
+    }
+
+    std::vector<ChunkPool::Handle> oldSlots;
+    oldSlots.swap(m_slots);
+
+    m_shift = shift;
+    m_size = 1 << shift;
+    m_mask = m_size - 1;
+    m_originX = m_centerX - m_size / 2;
+    m_originZ = m_centerZ - m_size / 2;
+    m_slots.resize(static_cast<size_t>(m_size) * m_size);
+
+    for (auto& slot : oldSlots) {
+        if (slot) {
+            Place(std::move(slot));
+        }
+    }
+
+    AdmitOverflow();
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include "ChunkPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Loaded chunks kept in a fixed toroidal window around the player, indexed
+// by (chunkX mod N, chunkZ mod N) so a lookup is one array load. Moving the
+// window only relocates the chunks crossing its edge. Chunks outside the
+// window (e.g. not yet unloaded after the window moved) live in a hash map.
+class ChunkGrid {
+public:
+    explicit ChunkGrid(int windowRadius);
+
+    ChunkGrid(const ChunkGrid&) = delete;
+    ChunkGrid& operator=(const ChunkGrid&) = delete;
+
+    Chunk* Find(int chunkX, int chunkZ) { return FindLoaded(chunkX, chunkZ); }
+    const Chunk* Find(int chunkX, int chunkZ) const { return FindLoaded(chunkX, chunkZ); }
+
+    // Keyed by the chunk's own coordinates, which must not be loaded yet
+    Chunk* Insert(ChunkPool::Handle chunk);
+    ChunkPool::Handle Remove(int chunkX, int chunkZ);
+
+    // Slides the window so it is centered on the given chunk
+    void Recenter(int centerX, int centerZ);
+    // Resizes the window to cover at least radius chunks around its center
+    void SetWindowRadius(int radius);
+
+    size_t GetCount() const { return m_count; }
+    size_t GetOverflowCount() const { return m_overflow.size(); }
+    int GetWindowSize() const { return m_size; }
+
+    // fn(Chunk*) for every loaded chunk, fn(const Chunk*) through a const
+    // grid; the grid must not change meanwhile
+    template <typename Fn>
+    void ForEach(Fn&& fn) {
+        ForEachLoaded([&fn](Chunk* chunk) { fn(chunk); });
+    }
+    template <typename Fn>
+    void ForEach(Fn&& fn) const {
+        ForEachLoaded([&fn](const Chunk* chunk) { fn(chunk); });
+    }
+
+private:
+    Chunk* FindLoaded(int chunkX, int chunkZ) const {
+        if (InWindow(chunkX, chunkZ)) {
+            // The window is N wide, so a slot's occupant is the only
+            // chunk inside the window that maps to it
+            return m_slots[GetSlotIndex(chunkX, chunkZ)].get();
+        }
+        return m_overflow.empty() ? nullptr : FindOverflow(chunkX, chunkZ);
+    }
+    template <typename Fn>
+    void ForEachLoaded(Fn&& fn) const {
+        for (const auto& slot : m_slots) {
+            if (slot) fn(slot.get());
+        }
+        for (const auto& entry : m_overflow) {
+            fn(entry.second.get());
+        }
+    }
+
+    static uint64_t GetKey(int chunkX, int chunkZ) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(chunkX)) << 32) | static_cast<uint32_t>(chunkZ);
+    }
+    bool InWindow(int chunkX, int chunkZ) const {
+        return static_cast<unsigned>(chunkX - m_originX) < static_cast<unsigned>(m_size) &&
+               static_cast<unsigned>(chunkZ - m_originZ) < static_cast<unsigned>(m_size);
+    }
+    size_t GetSlotIndex(int chunkX, int chunkZ) const {
+        return (static_cast<size_t>(chunkX & m_mask) << m_shift) | static_cast<size_t>(chunkZ & m_mask);
+    }
+    Chunk* FindOverflow(int chunkX, int chunkZ) const;
+    void Place(ChunkPool::Handle chunk);
+    // Moves overflow chunks that the window now covers into their slots
+    void AdmitOverflow();
+
+    // Window of m_size x m_size chunks (a power of two) starting at the origin
+    int m_shift;
+    int m_size;
+    int m_mask;
+    int m_centerX, m_centerZ;
+    int m_originX, m_originZ;
+    size_t m_count;
+
+    std::vector<ChunkPool::Handle> m_slots;
+    std::unordered_map<uint64_t, ChunkPool::Handle> m_overflow;
+};
@@ -0,0 +1,49 @@
+#include "ChunkPool.h"
+#include <new>
+
+ChunkPool::ChunkPool(size_t chunksPerSlab)
+    : m_chunksPerSlab(chunksPerSlab)
+    , m_slotsUsedInLastSlab(chunksPerSlab) {
+}
+
+ChunkPool::~ChunkPool() {
+    // Every handle must be gone by now; only pooled chunks are still constructed
+    for (Chunk* chunk : m_freeChunks) {
+        chunk->~Chunk();
+    }
+}
+
+ChunkPool::Handle ChunkPool::Acquire(int chunkX, int chunkZ) {
+    Chunk* chunk = nullptr;
+
+    if (!m_freeChunks.empty()) {
+        chunk = m_freeChunks.back();
+        m_freeChunks.pop_back();
+        chunk->Reset(chunkX, chunkZ);
+        m_stats.hits++;
+    } else {
+        if (m_slotsUsedInLastSlab == m_chunksPerSlab) {
+            m_slabs.push_back(std::make_unique<Slot[]>(m_chunksPerSlab));
+            m_slotsUsedInLastSlab = 0;
+        }
+        Slot& slot = m_slabs.back()[m_slotsUsedInLastSlab++];
+        chunk = new (slot.bytes) Chunk(chunkX, chunkZ);
+        m_stats.misses++;
+    }
+
+    m_stats.liveCount++;
+    return Handle(chunk, Releaser{ this });
+}
+
+void ChunkPool::Release(Chunk* chunk) {
+    chunk->Retire();
+    m_freeChunks.push_back(chunk);
+    m_stats.liveCount--;
+}
+
+ChunkPool::Stats ChunkPool::GetStats() const {
+    Stats stats = m_stats;
+    stats.slabCount = m_slabs.size();
+    stats.freeCount = m_freeChunks.size();
+    return stats;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "Chunk.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Recycles Chunk objects instead of freeing them. Chunks are constructed in
+// place inside large slabs, and a released chunk is retired, freeing its
+// blocks and mesh, and kept on a free list for the next chunk.
+class ChunkPool {
+public:
+    struct Releaser {
+        ChunkPool* pool = nullptr;
+        void operator()(Chunk* chunk) const { pool->Release(chunk); }
+    };
+    using Handle = std::unique_ptr<Chunk, Releaser>;
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        size_t slabCount = 0;
+        size_t freeCount = 0;
+        size_t liveCount = 0;
+    };
+
+    explicit ChunkPool(size_t chunksPerSlab = 64);
+    ~ChunkPool();
+
+    ChunkPool(const ChunkPool&) = delete;
+    ChunkPool& operator=(const ChunkPool&) = delete;
+
+    Handle Acquire(int chunkX, int chunkZ);
+    Stats GetStats() const;
+
+private:
+    struct alignas(Chunk) Slot {
+        unsigned char bytes[sizeof(Chunk)];
+    };
+
+    void Release(Chunk* chunk);
+
+    size_t m_chunksPerSlab;
+    std::vector<std::unique_ptr<Slot[]>> m_slabs;
+    size_t m_slotsUsedInLastSlab;
+    std::vector<Chunk*> m_freeChunks;
+    Stats m_stats;
+};
@@ -0,0 +1,165 @@
+#include "ChunkScheduler.h"
+#include "Chunk.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // Turning further than this (about 15 degrees) reorders the queue
+    const float kReplanTurnCos = 0.966f;
+    // Chunks straight behind the player wait as if they were this much farther
+    const float kBehindPenalty = 2.0f;
+    // Chunks this close load first whatever the view direction
+    const float kNearRadius = 1.5f;
+
+    // Unit horizontal direction, or zero for (nearly) vertical vectors
+    Vector3 GetHorizontalDirection(const Vector3& v) {
+        Vector3 flat(v.x, 0.0f, v.z);
+        float length = flat.length();
+        return length < 0.1f ? Vector3(0, 0, 0) : flat / length;
+    }
+
+    bool IsSameDirection(const Vector3& a, const Vector3& b) {
+        bool aZero = a.x == 0.0f && a.z == 0.0f;
+        bool bZero = b.x == 0.0f && b.z == 0.0f;
+        return aZero || bZero ? aZero == bZero : a.dot(b) >= kReplanTurnCos;
+    }
+}
+
+ChunkScheduler::ChunkScheduler()
+    : m_planned(false)
+    , m_centerX(0)
+    , m_centerZ(0)
+    , m_radius(0)
+    , m_forward(0, 0, 0)
+    , m_motion(0, 0, 0)
+    , m_lead(0)
+    , m_leadX(0)
+    , m_leadZ(0)
+    , m_ticketsVersion(0) {
+}
+
+double ChunkScheduler::GetStageBudget(Stage stage) const {
+    switch (stage) {
+    case Generate: return m_budget.generateMs;
+    case Mesh:     return m_budget.meshMs;
+    case Upload:   return m_budget.uploadMs;
+    default:       return 0.0;
+    }
+}
+
+bool ChunkScheduler::HasPendingWork() const {
+    for (size_t pending : m_stats.pending) {
+        if (pending > 0) return true;
+    }
+    return false;
+}
+
+void ChunkScheduler::Plan(int centerX, int centerZ, const Vector3& viewDirection, const Vector3& velocity, int radius,
+                          const ChunkTickets* tickets) {
+    Vector3 forward = GetHorizontalDirection(viewDirection);
+    Vector3 motion(0, 0, 0);
+    int lead = 0;
+    float speed = Vector3(velocity.x, 0.0f, velocity.z).length();
+    if (m_policy.enabled && speed >= m_policy.minSpeed) {
+        motion = GetHorizontalDirection(velocity);
+        float leadChunks = speed * m_policy.leadSeconds / CHUNK_SIZE;
+        lead = std::min(static_cast<int>(leadChunks + 0.5f), m_policy.maxLeadChunks);
+        // Weigh the direction of travel as much as the view
+        Vector3 heading = forward + motion;
+        forward = heading.length() < 0.1f ? motion : GetHorizontalDirection(heading);
+    }
+
+    uint64_t ticketsVersion = tickets ? tickets->GetVersion() : 0;
+    if (m_planned && centerX == m_centerX && centerZ == m_centerZ && radius == m_radius && lead == m_lead &&
+        IsSameDirection(forward, m_forward) && IsSameDirection(motion, m_motion) && ticketsVersion == m_ticketsVersion) {
+        return;
+    }
+    m_planned = true;
+    m_centerX = centerX;
+    m_centerZ = centerZ;
+    m_radius = radius;
+    m_forward = forward;
+    m_motion = motion;
+    m_lead = lead;
+    m_ticketsVersion = ticketsVersion;
+    m_leadX = centerX + static_cast<int>(std::lround(motion.x * lead));
+    m_leadZ = centerZ + static_cast<int>(std::lround(motion.z * lead));
+    m_stats.replans++;
+
+    struct Candidate {
+        int dx, dz;
+        float priority;
+    };
+    std::vector<Candidate> candidates;
+    int extent = radius + lead;
+    candidates.reserve(static_cast<size_t>((2 * extent + 1) * (2 * extent + 1)));
+
+    for (int dx = -extent; dx <= extent; dx++) {
+        for (int dz = -extent; dz <= extent; dz++) {
+            int leadDx = centerX + dx - m_leadX;
+            int leadDz = centerZ + dz - m_leadZ;
+            if (dx * dx + dz * dz > radius * radius &&
+                (lead == 0 || leadDx * leadDx + leadDz * leadDz > radius * radius)) {
+                continue;
+            }
+
+            float distance = std::sqrt(static_cast<float>(dx * dx + dz * dz));
+            float priority = distance;
+            if (distance > kNearRadius) {
+                // 1x straight ahead up to kBehindPenalty x straight behind
+                float facing = Vector3(static_cast<float>(dx), 0.0f, static_cast<float>(dz)).dot(forward) / distance;
+                priority *= 1.0f + (kBehindPenalty - 1.0f) * (1.0f - facing) * 0.5f;
+            }
+            candidates.push_back({ dx, dz, priority });
+        }
+    }
+
+    // Other observers' chunks by distance to the ticket over its weight; a
+    // chunk wanted by several observers keeps its most urgent entry
+    if (tickets && tickets->GetTicketCount() > 0) {
+        tickets->ForEach([&](ChunkTickets::TicketId, const ChunkTickets::Ticket& ticket) {
+            for (int tx = -ticket.radius; tx <= ticket.radius; tx++) {
+                for (int tz = -ticket.radius; tz <= ticket.radius; tz++) {
+                    if (tx * tx + tz * tz > ticket.radius * ticket.radius) {
+                        continue;
+                    }
+                    float distance = std::sqrt(static_cast<float>(tx * tx + tz * tz));
+                    candidates.push_back({ ticket.chunkX + tx - centerX, ticket.chunkZ + tz - centerZ,
+                                           distance / ticket.weight });
+                }
+            }
+        });
+
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+            if (a.dx != b.dx) return a.dx < b.dx;
+            if (a.dz != b.dz) return a.dz < b.dz;
+            return a.priority < b.priority;
+        });
+        candidates.erase(std::unique(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+            return a.dx == b.dx && a.dz == b.dz;
+        }), candidates.end());
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        return a.priority < b.priority;
+    });
+
+    m_order.clear();
+    for (const Candidate& candidate : candidates) {
+        m_order.push_back(std::make_pair(centerX + candidate.dx, centerZ + candidate.dz));
+    }
+}
+
+bool ChunkScheduler::ShouldKeep(int chunkX, int chunkZ, int margin) const {
+    int dx = chunkX - m_centerX;
+    int dz = chunkZ - m_centerZ;
+    int limit = m_radius + margin;
+    // Chunks behind the direction of travel will not be needed again soon
+    if (dx * m_motion.x + dz * m_motion.z < 0.0f) {
+        limit = m_radius + std::min(margin, m_policy.trailingUnloadMargin);
+    }
+    if (std::max(std::abs(dx), std::abs(dz)) <= limit) {
+        return true;
+    }
+    return m_lead > 0 && std::max(std::abs(chunkX - m_leadX), std::abs(chunkZ - m_leadZ)) <= m_radius + margin;
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include "ChunkTickets.h"
+#include "MathUtils.h"
+#include <chrono>
+#include <utility>
+#include <vector>
+
+// Per-frame time budgets for each chunk stage, in milliseconds (0 = unlimited).
+// At least one item per stage runs every frame so loading always progresses.
+struct ChunkLoadBudget {
+    double generateMs = 3.0;
+    double meshMs = 3.0;
+    double uploadMs = 2.0;
+};
+
+// Biases loading toward where the player is heading. While moving faster
+// than minSpeed (blocks/s), chunks are also loaded around a lead point
+// leadSeconds of travel ahead (at most maxLeadChunks), the queue favors the
+// direction of travel as well as the view, and chunks trailing the motion
+// are unloaded trailingUnloadMargin chunks past the render distance instead
+// of the usual margin.
+struct ChunkPrefetchPolicy {
+    bool enabled = true;
+    float minSpeed = 4.0f;
+    float leadSeconds = 2.0f;
+    int maxLeadChunks = 4;
+    int trailingUnloadMargin = 0;
+};
+
+// Orders the chunks inside a circular radius around the player (and the
+// prefetch lead point) and around other observers' load tickets, nearest
+// (relative to ticket weight) and most in front first, and runs each
+// stage's work down that order until the stage's time budget is spent. The
+// order is rebuilt whenever the player changes chunk, turns or changes
+// course, or a ticket changes, so work for chunks that fell out of range is dropped and the rest
+// is reprioritized.
+class ChunkScheduler {
+public:
+    enum Stage {
+        Generate = 0,
+        Mesh = 1,
+        Upload = 2,
+        StageCount
+    };
+
+    struct Stats {
+        size_t pending[StageCount] = {};
+        uint64_t completed[StageCount] = {};
+        double lastFrameMs[StageCount] = {};
+        uint64_t replans = 0;
+    };
+
+    ChunkScheduler();
+
+    void SetBudget(const ChunkLoadBudget& budget) { m_budget = budget; }
+    const ChunkLoadBudget& GetBudget() const { return m_budget; }
+    void SetPrefetchPolicy(const ChunkPrefetchPolicy& policy) { m_policy = policy; m_planned = false; }
+    const ChunkPrefetchPolicy& GetPrefetchPolicy() const { return m_policy; }
+
+    // Cheap when nothing changed since the last call. Velocity is in blocks/s.
+    // Chunks in the tickets' areas are queued too, each once.
+    void Plan(int centerX, int centerZ, const Vector3& viewDirection, const Vector3& velocity, int radius,
+              const ChunkTickets* tickets = nullptr);
+    const std::vector<std::pair<int, int>>& GetOrder() const { return m_order; }
+    // Whether a loaded chunk should stay loaded under the current plan: within
+    // radius + margin of the player or the lead point, Chebyshev distance
+    bool ShouldKeep(int chunkX, int chunkZ, int margin) const;
+    // Chunks ahead of the player that the plan covers (0 when not moving)
+    int GetLeadChunks() const { return m_lead; }
+
+    // Calls fn(chunkX, chunkZ) in priority order until the stage's budget is
+    // spent; fn returns whether it did any work for that chunk
+    template <typename Fn>
+    int Run(Stage stage, Fn&& fn) {
+        double budgetMs = GetStageBudget(stage);
+        auto start = Clock::now();
+        int done = 0;
+        for (const auto& coord : m_order) {
+            if (done > 0 && budgetMs > 0.0 && ElapsedMs(start) >= budgetMs) {
+                break;
+            }
+            if (fn(coord.first, coord.second)) {
+                done++;
+            }
+        }
+        m_stats.completed[stage] += static_cast<uint64_t>(done);
+        m_stats.lastFrameMs[stage] = ElapsedMs(start);
+        return done;
+    }
+
+    void SetPending(Stage stage, size_t count) { m_stats.pending[stage] = count; }
+    bool HasPendingWork() const;
+    const Stats& GetStats() const { return m_stats; }
+
+private:
+    using Clock = std::chrono::high_resolution_clock;
+
+    static double ElapsedMs(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+    double GetStageBudget(Stage stage) const;
+
+    ChunkLoadBudget m_budget;
+    std::vector<std::pair<int, int>> m_order;
+    ChunkPrefetchPolicy m_policy;
+    bool m_planned;
+    int m_centerX, m_centerZ;
+    int m_radius;
+    Vector3 m_forward;
+    // Unit horizontal direction of travel, or zero below minSpeed
+    Vector3 m_motion;
+    int m_lead;
+    int m_leadX, m_leadZ;
+    uint64_t m_ticketsVersion;
+    Stats m_stats;
+};
@@ -0,0 +1,234 @@
+#include "ChunkSection.h"
+#include <algorithm>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+
+namespace {
+    // Weak table of every mixed section's storage, keyed by content hash.
+    // Holding weak pointers means the table never keeps storage alive.
+    class SectionInterner {
+    public:
+        std::shared_ptr<ChunkBlockStorage> Intern(const std::shared_ptr<ChunkBlockStorage>& data) {
+            uint64_t hash = Hash(*data);
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto range = m_entries.equal_range(hash);
+            for (auto it = range.first; it != range.second; ++it) {
+                std::shared_ptr<ChunkBlockStorage> existing = it->second.lock();
+                if (existing && existing != data && Equal(*existing, *data)) {
+                    return existing;
+                }
+            }
+
+            m_entries.emplace(hash, data);
+            if (m_entries.size() > m_pruneThreshold) {
+                Prune();
+            }
+            return data;
+        }
+
+    private:
+        static uint64_t Hash(const ChunkBlockStorage& data) {
+            // FNV-1a over the block types
+            uint64_t hash = 14695981039346656037ull;
+            for (size_t i = 0; i < static_cast<size_t>(SECTION_VOLUME); i++) {
+                hash ^= static_cast<uint64_t>(data.Get(i));
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+
+        static bool Equal(const ChunkBlockStorage& a, const ChunkBlockStorage& b) {
+            for (size_t i = 0; i < static_cast<size_t>(SECTION_VOLUME); i++) {
+                if (a.Get(i) != b.Get(i)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void Prune() {
+            for (auto it = m_entries.begin(); it != m_entries.end();) {
+                if (it->second.expired()) {
+                    it = m_entries.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            m_pruneThreshold = std::max<size_t>(1024, m_entries.size() * 2);
+        }
+
+        std::mutex m_mutex;
+        std::unordered_multimap<uint64_t, std::weak_ptr<ChunkBlockStorage>> m_entries;
+        size_t m_pruneThreshold = 1024;
+    };
+
+    SectionInterner& GetInterner() {
+        static SectionInterner interner;
+        return interner;
+    }
+}
+
+ChunkSection::ChunkSection()
+    : m_interned(false)
+    , m_uniformType(BlockType::Air) {
+    ResetTypeCounts(BlockType::Air);
+}
+
+void ChunkSection::Set(int x, int y, int z, BlockType type) {
+    BlockType oldType = Get(x, y, z);
+    if (oldType == type) {
+        return;
+    }
+    if (m_states) {
+        ClearState(x, y, z);
+    }
+
+    Unshare();
+    m_data->Set(GetIndex(x, y, z), type);
+
+    if (--m_typeCounts[static_cast<size_t>(oldType)] == 0) {
+        m_typeMask &= ~GetTypeBit(oldType);
+    }
+    m_typeCounts[static_cast<size_t>(type)]++;
+    m_typeMask |= GetTypeBit(type);
+}
+
+void ChunkSection::ReadAll(BlockType* out) const {
+    if (!m_data) {
+        std::fill(out, out + SECTION_VOLUME, m_uniformType);
+    } else if constexpr (std::is_same<ChunkLayout, XMajorLayout>::value) {
+        m_data->ReadAll(out);
+    } else {
+        std::array<BlockType, SECTION_VOLUME> stored;
+        m_data->ReadAll(stored.data());
+        for (int x = 0; x < SECTION_SIZE; x++) {
+            for (int y = 0; y < SECTION_SIZE; y++) {
+                for (int z = 0; z < SECTION_SIZE; z++) {
+                    out[XMajorLayout::Index(x, y, z)] = stored[GetIndex(x, y, z)];
+                }
+            }
+        }
+    }
+}
+
+void ChunkSection::Fill(BlockType type) {
+    m_data.reset();
+    m_interned = false;
+    m_uniformType = type;
+    m_states.reset();
+    ResetTypeCounts(type);
+}
+
+void ChunkSection::Unshare() {
+    if (!m_data) {
+        m_data = std::make_shared<ChunkBlockStorage>(static_cast<size_t>(SECTION_VOLUME), m_uniformType);
+    } else if (m_interned || m_data.use_count() > 1) {
+        // Copy on write
+        m_data = std::make_shared<ChunkBlockStorage>(*m_data);
+        m_interned = false;
+    }
+}
+
+void ChunkSection::BeginWrites(uint32_t typeMask) {
+    Unshare();
+    m_data->AddTypes(typeMask);
+}
+
+void ChunkSection::EndWrites() {
+    m_data->CountTypes(m_typeCounts);
+    m_typeMask = 0;
+    for (size_t type = 0; type < m_typeCounts.size(); type++) {
+        if (m_typeCounts[type] > 0) {
+            m_typeMask |= 1u << type;
+        }
+    }
+}
+
+void ChunkSection::ResetTypeCounts(BlockType type) {
+    m_typeCounts.fill(0);
+    m_typeCounts[static_cast<size_t>(type)] = SECTION_VOLUME;
+    m_typeMask = GetTypeBit(type);
+}
+
+BlockState ChunkSection::GetState(int x, int y, int z) const {
+    if (!m_states) {
+        return 0;
+    }
+    auto it = m_states->find(GetStateKey(x, y, z));
+    return it != m_states->end() ? it->second : 0;
+}
+
+void ChunkSection::SetState(int x, int y, int z, BlockState state) {
+    if (state == 0) {
+        ClearState(x, y, z);
+        return;
+    }
+
+    if (!m_states) {
+        m_states = std::make_shared<StateTable>();
+    } else if (m_states.use_count() > 1) {
+        m_states = std::make_shared<StateTable>(*m_states);
+    }
+    (*m_states)[GetStateKey(x, y, z)] = state;
+}
+
+void ChunkSection::ClearState(int x, int y, int z) {
+    if (!m_states) {
+        return;
+    }
+
+    uint16_t key = GetStateKey(x, y, z);
+    if (m_states->find(key) == m_states->end()) {
+        return;
+    }
+
+    if (m_states->size() == 1) {
+        m_states.reset();
+        return;
+    }
+    if (m_states.use_count() > 1) {
+        m_states = std::make_shared<StateTable>(*m_states);
+    }
+    m_states->erase(key);
+}
+
+void ChunkSection::Compact() {
+    if (!m_data || m_interned) {
+        return;
+    }
+
+    if (CollapseIfUniform()) {
+        return;
+    }
+
+    m_data = GetInterner().Intern(m_data);
+    m_interned = true;
+}
+
+bool ChunkSection::CollapseIfUniform() {
+    BlockType uniformType;
+    if (!m_data || !m_data->IsUniform(uniformType)) {
+        return false;
+    }
+    m_data.reset();
+    m_interned = false;
+    m_uniformType = uniformType;
+    return true;
+}
+
+size_t ChunkSection::GetMemoryUsage() const {
+    size_t usage = sizeof(*this);
+    if (m_data) {
+        usage += m_data->GetMemoryUsage() / static_cast<size_t>(m_data.use_count());
+    }
+    if (m_states) {
+        // Approximate node-based hash table cost: one node per entry plus buckets
+        size_t stateBytes = sizeof(StateTable) +
+                            m_states->size() * (sizeof(StateTable::value_type) + 2 * sizeof(void*)) +
+                            m_states->bucket_count() * sizeof(void*);
+        usage += stateBytes / static_cast<size_t>(m_states.use_count());
+    }
+    return usage;
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include "Block.h"
+#include "BlockLayout.h"
+#include "BlockStorage.h"
+#include <cstddef>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+const int SECTION_SIZE = 16;
+const int SECTION_SHIFT = 4;
+const int SECTION_MASK = SECTION_SIZE - 1;
+const int SECTION_VOLUME = SECTION_SIZE * SECTION_SIZE * SECTION_SIZE;
+
+// A 16x16x16 slice of a chunk column. Sections that hold a single block
+// type (all air, all stone, ...) are stored as just that type. Mixed
+// sections point at block storage that may be shared with other identical
+// sections and is copied on the first write.
+class ChunkSection {
+public:
+    ChunkSection();
+
+    BlockType Get(int x, int y, int z) const {
+        return m_data ? m_data->Get(GetIndex(x, y, z)) : m_uniformType;
+    }
+    // All blocks into out[x << 8 | y << 4 | z] whatever the storage layout,
+    // so each row of z is 16 consecutive bytes
+    void ReadAll(BlockType* out) const;
+    // Changing a block's type clears its state
+    void Set(int x, int y, int z, BlockType type);
+    void Fill(BlockType type);
+
+    // Bulk writes: BeginWrites makes the storage private once (expanding a
+    // uniform section, copying shared storage) and makes room for the types
+    // about to be written (bit 1 << type), Write stores a type without Set's
+    // per-block bookkeeping, and EndWrites recounts the types once. As with
+    // Set, a block whose type changes loses its state.
+    void BeginWrites(uint32_t typeMask);
+    void Write(int x, int y, int z, BlockType type) {
+        size_t index = GetIndex(x, y, z);
+        if (m_states && m_data->Get(index) != type) {
+            ClearState(x, y, z);
+        }
+        m_data->Set(index, type);
+    }
+    void EndWrites();
+
+    // Sparse side table for the few blocks with non-default state, keyed by
+    // layout-independent local index (x << 8 | y << 4 | z)
+    BlockState GetState(int x, int y, int z) const;
+    void SetState(int x, int y, int z, BlockState state);
+    size_t GetStateCount() const { return m_states ? m_states->size() : 0; }
+    template <typename Fn>
+    void ForEachState(Fn&& fn) const {
+        if (!m_states) return;
+        for (const auto& entry : *m_states) {
+            fn(entry.first >> 8, (entry.first >> 4) & 15, entry.first & 15, entry.second);
+        }
+    }
+
+    bool IsUniform() const { return !m_data; }
+    bool IsEmpty() const { return !m_data && m_uniformType == BlockType::Air; }
+    BlockType GetUniformType() const { return m_uniformType; }
+    bool IsShared() const { return m_data && m_data.use_count() > 1; }
+
+    // Which block types the section holds (bit 1 << type) and how many of
+    // each, kept up to date by Set and Fill so queries can skip sections
+    uint32_t GetTypeMask() const { return m_typeMask; }
+    bool Contains(BlockType type) const { return (m_typeMask & GetTypeBit(type)) != 0; }
+    int GetTypeCount(BlockType type) const { return m_typeCounts[static_cast<size_t>(type)]; }
+    static uint32_t GetTypeBit(BlockType type) { return 1u << static_cast<uint32_t>(type); }
+
+    // Collapses single-type sections back to a tag and shares the storage
+    // of mixed sections with any identical section elsewhere in the world.
+    // Interned storage is never written again, so worker threads can
+    // compact their chunks while the main thread edits others.
+    void Compact();
+    // Just the first half of Compact: drops storage holding a single type
+    bool CollapseIfUniform();
+
+    // Shared storage is split evenly between the sections referencing it
+    size_t GetMemoryUsage() const;
+
+    static size_t GetIndex(int x, int y, int z) { return ChunkLayout::Index(x, y, z); }
+
+private:
+    using StateTable = std::unordered_map<uint16_t, BlockState>;
+
+    static uint16_t GetStateKey(int x, int y, int z) {
+        return static_cast<uint16_t>((x << 8) | (y << 4) | z);
+    }
+    void ClearState(int x, int y, int z);
+    void ResetTypeCounts(BlockType type);
+    // Private storage for writing: expands a uniform section, copies shared storage
+    void Unshare();
+
+    std::shared_ptr<ChunkBlockStorage> m_data;
+    // m_data is in the interner; the next write copies it
+    bool m_interned;
+    BlockType m_uniformType;
+    // Copy-on-write like m_data; null while no block has state
+    std::shared_ptr<StateTable> m_states;
+    std::array<uint16_t, static_cast<size_t>(BlockType::Count)> m_typeCounts;
+    uint32_t m_typeMask;
+};
@@ -0,0 +1,73 @@
+#include "ChunkTickets.h"
+#include <algorithm>
+
+ChunkTickets::ChunkTickets(int keepMargin)
+    : m_keepMargin(keepMargin)
+    , m_nextId(1)
+    , m_version(0) {
+}
+
+ChunkTickets::TicketId ChunkTickets::Add(int chunkX, int chunkZ, int radius, float weight) {
+    TicketId id = m_nextId++;
+    Ticket& ticket = m_tickets[id];
+    ticket.chunkX = chunkX;
+    ticket.chunkZ = chunkZ;
+    ticket.radius = std::max(radius, 0);
+    ticket.weight = std::max(weight, 0.01f);
+    Hold(ticket, 1);
+    m_version++;
+    return id;
+}
+
+void ChunkTickets::Move(TicketId id, int chunkX, int chunkZ) {
+    auto it = m_tickets.find(id);
+    if (it == m_tickets.end() || (it->second.chunkX == chunkX && it->second.chunkZ == chunkZ)) {
+        return;
+    }
+    Hold(it->second, -1);
+    it->second.chunkX = chunkX;
+    it->second.chunkZ = chunkZ;
+    Hold(it->second, 1);
+    m_version++;
+}
+
+void ChunkTickets::SetRadius(TicketId id, int radius) {
+    auto it = m_tickets.find(id);
+    radius = std::max(radius, 0);
+    if (it == m_tickets.end() || it->second.radius == radius) {
+        return;
+    }
+    Hold(it->second, -1);
+    it->second.radius = radius;
+    Hold(it->second, 1);
+    m_version++;
+}
+
+void ChunkTickets::Remove(TicketId id) {
+    auto it = m_tickets.find(id);
+    if (it == m_tickets.end()) {
+        return;
+    }
+    Hold(it->second, -1);
+    m_tickets.erase(it);
+    m_version++;
+}
+
+const ChunkTickets::Ticket* ChunkTickets::Find(TicketId id) const {
+    auto it = m_tickets.find(id);
+    return it != m_tickets.end() ? &it->second : nullptr;
+}
+
+void ChunkTickets::Hold(const Ticket& ticket, int delta) {
+    int extent = ticket.radius + m_keepMargin;
+    for (int chunkX = ticket.chunkX - extent; chunkX <= ticket.chunkX + extent; chunkX++) {
+        for (int chunkZ = ticket.chunkZ - extent; chunkZ <= ticket.chunkZ + extent; chunkZ++) {
+            uint64_t key = GetKey(chunkX, chunkZ);
+            int& count = m_refCounts[key];
+            count += delta;
+            if (count <= 0) {
+                m_refCounts.erase(key);
+            }
+        }
+    }
+}
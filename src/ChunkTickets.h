@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+// Load tickets held by observers other than the player (spectator cameras,
+// benchmark probes, remote clients). A ticket asks for the chunks within a
+// circular radius around its chunk, loaded with a priority scaled by its
+// weight. Every chunk counts the tickets holding it, out to the radius plus
+// a keep margin (Chebyshev distance, as for the player), so overlapping
+// areas are loaded once and a chunk stays until its last ticket lets go.
+class ChunkTickets {
+public:
+    using TicketId = uint32_t;
+
+    struct Ticket {
+        int chunkX, chunkZ;
+        int radius;
+        // Higher loads sooner: distances are divided by it when ordering
+        float weight;
+    };
+
+    explicit ChunkTickets(int keepMargin);
+
+    ChunkTickets(const ChunkTickets&) = delete;
+    ChunkTickets& operator=(const ChunkTickets&) = delete;
+
+    TicketId Add(int chunkX, int chunkZ, int radius, float weight);
+    // Unknown ids are ignored
+    void Move(TicketId id, int chunkX, int chunkZ);
+    void SetRadius(TicketId id, int radius);
+    void Remove(TicketId id);
+    const Ticket* Find(TicketId id) const;
+
+    // Number of tickets holding a chunk
+    int GetRefCount(int chunkX, int chunkZ) const {
+        auto it = m_refCounts.find(GetKey(chunkX, chunkZ));
+        return it != m_refCounts.end() ? it->second : 0;
+    }
+    size_t GetTicketCount() const { return m_tickets.size(); }
+    size_t GetHeldChunkCount() const { return m_refCounts.size(); }
+    // Changes whenever a ticket is added, moved, resized or removed
+    uint64_t GetVersion() const { return m_version; }
+
+    // fn(TicketId, const Ticket&) for every ticket
+    template <typename Fn>
+    void ForEach(Fn&& fn) const {
+        for (const auto& entry : m_tickets) {
+            fn(entry.first, entry.second);
+        }
+    }
+
+private:
+    static uint64_t GetKey(int chunkX, int chunkZ) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(chunkX)) << 32) | static_cast<uint32_t>(chunkZ);
+    }
+    // Adds delta to the count of every chunk the ticket holds
+    void Hold(const Ticket& ticket, int delta);
+
+    int m_keepMargin;
+    TicketId m_nextId;
+    uint64_t m_version;
+    std::unordered_map<TicketId, Ticket> m_tickets;
+    std::unordered_map<uint64_t, int> m_refCounts;
+};
@@ -0,0 +1,115 @@
+#include "ChunkWorkers.h"
+#include "TerrainGenerator.h"
+#include <algorithm>
+
+namespace {
+    // Queued jobs per thread: enough to cover an update, few enough that
+    // a replan is not stuck behind stale work
+    const size_t kJobsPerThread = 4;
+}
+
+ChunkWorkers::ChunkWorkers(const TerrainGenerator& generator, int threadCount)
+    : m_generator(generator)
+    , m_queuedMeshJobs(0)
+    , m_stopping(false)
+    , m_completed(nullptr)
+    , m_inFlight() {
+    for (int i = 0; i < threadCount; i++) {
+        m_threads.emplace_back(&ChunkWorkers::WorkerMain, this);
+    }
+}
+
+ChunkWorkers::~ChunkWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+
+    // Unstarted and undrained jobs hand their chunks back to the pools here,
+    // on the owning thread
+    for (Job* job : m_queue) {
+        delete job;
+    }
+    std::vector<std::unique_ptr<Job>> completed;
+    Drain(completed);
+}
+
+bool ChunkWorkers::IsSaturated(JobType type) const {
+    return !m_threads.empty() && m_inFlight[type] >= m_threads.size() * kJobsPerThread;
+}
+
+void ChunkWorkers::Submit(std::unique_ptr<Job> job) {
+    m_inFlight[job->type]++;
+    if (m_threads.empty()) {
+        Execute(*job);
+        PushCompleted(job.release());
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (job->type == MeshJob) {
+            m_queue.insert(m_queue.begin() + m_queuedMeshJobs++, job.release());
+        } else {
+            m_queue.push_back(job.release());
+        }
+    }
+    m_wake.notify_one();
+}
+
+void ChunkWorkers::Drain(std::vector<std::unique_ptr<Job>>& completed) {
+    Job* job = m_completed.exchange(nullptr, std::memory_order_acquire);
+
+    // The stack is newest first
+    size_t first = completed.size();
+    for (; job; job = job->next) {
+        completed.emplace_back(job);
+        m_inFlight[job->type]--;
+    }
+    std::reverse(completed.begin() + first, completed.end());
+}
+
+void ChunkWorkers::WorkerMain() {
+    for (;;) {
+        Job* job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_stopping || !m_queue.empty(); });
+            if (m_stopping) {
+                return;
+            }
+            job = m_queue.front();
+            m_queue.pop_front();
+            if (job->type == MeshJob) {
+                m_queuedMeshJobs--;
+            }
+        }
+
+        Execute(*job);
+        PushCompleted(job);
+    }
+}
+
+void ChunkWorkers::Execute(Job& job) const {
+    switch (job.type) {
+    case GenerateJob:
+        m_generator.GenerateChunk(job.chunk.get());
+        break;
+    case MeshJob:
+        job.chunk->GenerateMesh(job.meshMode);
+        break;
+    default:
+        break;
+    }
+}
+
+void ChunkWorkers::PushCompleted(Job* job) {
+    Job* head = m_completed.load(std::memory_order_relaxed);
+    do {
+        job->next = head;
+    } while (!m_completed.compare_exchange_weak(head, job, std::memory_order_release, std::memory_order_relaxed));
+}
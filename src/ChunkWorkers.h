@@ -0,0 +1,77 @@
+#pragma once
+#include "ChunkPool.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TerrainGenerator;
+
+// Background threads that generate and mesh chunks. A job only ever touches
+// its own chunk (a fresh pooled chunk to generate into, or a snapshot to
+// mesh), never one the main thread can see, so its result is exactly what
+// the main thread would have produced. Finished jobs come back through a
+// lock-free queue that the main thread drains once or twice per update.
+class ChunkWorkers {
+public:
+    enum JobType {
+        GenerateJob,
+        MeshJob,
+        JobTypeCount
+    };
+
+    struct Job {
+        JobType type;
+        ChunkPool::Handle chunk;
+        // For mesh jobs: the live chunk and its revision when snapshotted
+        const Chunk* target = nullptr;
+        uint32_t revision = 0;
+        MeshMode meshMode = MeshMode::PerFace;
+        Job* next = nullptr;
+    };
+
+    // With no threads, Submit runs the job on the calling thread
+    ChunkWorkers(const TerrainGenerator& generator, int threadCount);
+    ~ChunkWorkers();
+
+    ChunkWorkers(const ChunkWorkers&) = delete;
+    ChunkWorkers& operator=(const ChunkWorkers&) = delete;
+
+    int GetThreadCount() const { return static_cast<int>(m_threads.size()); }
+
+    void Submit(std::unique_ptr<Job> job);
+    // Enough jobs of a type are queued to keep every thread busy until the
+    // next update. Types are capped separately, and mesh jobs run before
+    // queued generation, so meshing nearby chunks never waits for the
+    // generation of far ones.
+    bool IsSaturated(JobType type) const;
+    // Submitted jobs not yet drained
+    size_t GetInFlightCount() const { return m_inFlight[GenerateJob] + m_inFlight[MeshJob]; }
+
+    // Appends finished jobs to completed, oldest first
+    void Drain(std::vector<std::unique_ptr<Job>>& completed);
+
+private:
+    void WorkerMain();
+    void Execute(Job& job) const;
+    void PushCompleted(Job* job);
+
+    const TerrainGenerator& m_generator;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    // Mesh jobs first, each type in submission order
+    std::deque<Job*> m_queue;
+    size_t m_queuedMeshJobs;
+    bool m_stopping;
+
+    // Intrusive stack pushed by workers with a CAS; the main thread takes
+    // the whole stack at once, so there is no ABA problem
+    std::atomic<Job*> m_completed;
+    size_t m_inFlight[JobTypeCount];
+};
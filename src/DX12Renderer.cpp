@@ -805,7 +805,7 @@ void DX12Renderer::RenderUIInternal(const UIInfo& uiInfo) {
     if (uiInfo.showDebug) {
         Vector4 bgColor(0.0f, 0.0f, 0.0f, 0.5f);
         float bgWidth = 350.0f;
-        float bgHeight = uiInfo.isRaytracing ? 200.0f : 100.0f;
+        float bgHeight = uiInfo.isRaytracing ? 240.0f : 140.0f;
         float bgX = 10.0f;
         float bgY = 10.0f;
 
@@ -840,14 +840,20 @@ void DX12Renderer::RenderUIInternal(const UIInfo& uiInfo) {
             DrawTextInternal("Looking at: Nothing", 15.0f, 55.0f, 2.0f, Vector4(0.7f, 0.7f, 0.7f, 1), vertices, indices);
         }
 
+        char viewText[128];
+        sprintf(viewText, "View: %d (%s) %.1f / %.1f ms", uiInfo.renderDistance,
+                uiInfo.renderDistanceReason ? uiInfo.renderDistanceReason : "fixed",
+                uiInfo.frameMs, uiInfo.targetFrameMs);
+        DrawTextInternal(viewText, 15.0f, 95.0f, 2.0f, Vector4(0.9f, 0.9f, 0.9f, 1), vertices, indices);
+
         if (uiInfo.isRaytracing) {
             char camText[128];
             sprintf(camText, "Cam: (%.1f, %.1f, %.1f)", uiInfo.camPos.x, uiInfo.camPos.y, uiInfo.camPos.z);
-            DrawTextInternal(camText, 15.0f, 95.0f, 2.0f, Vector4(0.8f, 1.0f, 0.8f, 1), vertices, indices);
+            DrawTextInternal(camText, 15.0f, 135.0f, 2.0f, Vector4(0.8f, 1.0f, 0.8f, 1), vertices, indices);
 
             char rtText[128];
             sprintf(rtText, "RT Verts: %u  Tris: %u", uiInfo.rtVertexCount, uiInfo.rtTriangleCount);
-            DrawTextInternal(rtText, 15.0f, 135.0f, 2.0f, Vector4(0.8f, 0.8f, 1.0f, 1), vertices, indices);
+            DrawTextInternal(rtText, 15.0f, 175.0f, 2.0f, Vector4(0.8f, 0.8f, 1.0f, 1), vertices, indices);
 
             char asText[128];
             sprintf(asText, "BLAS: %s  TLAS: %s",
@@ -855,7 +861,7 @@ void DX12Renderer::RenderUIInternal(const UIInfo& uiInfo) {
                     uiInfo.rtTlasBuilt ? "OK" : "FAIL");
             Vector4 asColor = (uiInfo.rtBlasBuilt && uiInfo.rtTlasBuilt) ?
                               Vector4(0.0f, 1.0f, 0.0f, 1.0f) : Vector4(1.0f, 0.0f, 0.0f, 1.0f);
-            DrawTextInternal(asText, 15.0f, 175.0f, 2.0f, asColor, vertices, indices);
+            DrawTextInternal(asText, 15.0f, 215.0f, 2.0f, asColor, vertices, indices);
         }
     }
 
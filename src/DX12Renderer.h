@@ -30,6 +30,10 @@ public:
         Vector3 camPos;
         Vector3 camDir;
         const char* renderMode = nullptr;
+        int renderDistance = 0;
+        const char* renderDistanceReason = nullptr;
+        float frameMs = 0.0f;
+        float targetFrameMs = 0.0f;
         // Raytracing debug info
         bool isRaytracing = false;
         uint32_t rtVertexCount = 0;
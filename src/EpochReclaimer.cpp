@@ -0,0 +1,54 @@
+#include "EpochReclaimer.h"
+#include <algorithm>
+#include <thread>
+
+// Announcements, unpublishing and the owner's scan are all sequentially
+// consistent: a reader that the scan misses announced itself after the
+// object was unpublished, so it can only load the new one.
+
+EpochReclaimer::Guard::Guard(const EpochReclaimer& reclaimer)
+    : m_slot(nullptr) {
+    for (;;) {
+        uint64_t epoch = reclaimer.m_epoch.load();
+        for (Slot& slot : reclaimer.m_slots) {
+            uint64_t expected = 0;
+            if (slot.epoch.compare_exchange_strong(expected, epoch)) {
+                m_slot = &slot.epoch;
+                return;
+            }
+        }
+        std::this_thread::yield();
+    }
+}
+
+EpochReclaimer::Guard::~Guard() {
+    m_slot->store(0, std::memory_order_release);
+}
+
+EpochReclaimer::EpochReclaimer()
+    : m_epoch(1) {
+    for (Slot& slot : m_slots) {
+        slot.epoch.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t EpochReclaimer::Advance() {
+    uint64_t oldest = m_epoch.fetch_add(1) + 1;
+    for (const Slot& slot : m_slots) {
+        uint64_t epoch = slot.epoch.load();
+        if (epoch != 0) {
+            oldest = std::min(oldest, epoch);
+        }
+    }
+    return oldest;
+}
+
+int EpochReclaimer::GetActiveReaders() const {
+    int active = 0;
+    for (const Slot& slot : m_slots) {
+        if (slot.epoch.load(std::memory_order_relaxed) != 0) {
+            active++;
+        }
+    }
+    return active;
+}
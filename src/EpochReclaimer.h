@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Epoch-based reclamation: lets one owner thread free objects that reader
+// threads may still be looking at, without readers taking locks. A reader
+// holds a Guard while it uses shared objects; the guard announces the epoch
+// it started in. The owner unpublishes an object, stamps it with GetEpoch(),
+// and frees it once Advance() reports a safe epoch past that stamp: every
+// reader still inside started after the object was unpublished, so none
+// can reach it.
+class EpochReclaimer {
+public:
+    // Readers inside at once; more wait for a slot
+    static const int kMaxReaders = 64;
+
+    class Guard {
+    public:
+        explicit Guard(const EpochReclaimer& reclaimer);
+        ~Guard();
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+    private:
+        std::atomic<uint64_t>* m_slot;
+    };
+
+    EpochReclaimer();
+
+    EpochReclaimer(const EpochReclaimer&) = delete;
+    EpochReclaimer& operator=(const EpochReclaimer&) = delete;
+
+    // Owner thread only: the stamp for objects unpublished just now
+    uint64_t GetEpoch() const { return m_epoch.load(); }
+    // Owner thread only: starts a new epoch and returns the oldest one a
+    // reader may still be in. Objects stamped before it can be freed.
+    uint64_t Advance();
+    int GetActiveReaders() const;
+
+private:
+    // A slot holds the epoch its reader started in, or 0 when free; each
+    // sits on its own cache line so readers do not contend
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> epoch;
+    };
+
+    mutable Slot m_slots[kMaxReaders];
+    std::atomic<uint64_t> m_epoch;
+};
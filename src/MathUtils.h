@@ -59,8 +59,8 @@ struct Vector2 {
 struct Vector4 {
     float x, y, z, w;
 
-    Vector4() : x(0), y(0), z(0), w(0) {}
-    Vector4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+    constexpr Vector4() : x(0), y(0), z(0), w(0) {}
+    constexpr Vector4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
     Vector4(const Vector3& v, float w) : x(v.x), y(v.y), z(v.z), w(w) {}
 };
 
@@ -0,0 +1,43 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+enum class MemoryCategory : uint8_t {
+    BlockData = 0,  // Chunk section storage
+    CpuMesh = 1,    // Chunk vertex/index vectors
+    GpuMesh = 2,    // Chunk vertex/index buffers
+    ColdCache = 3,  // Compressed unloaded chunks
+    Count
+};
+
+// Running byte totals for world memory, by category, with an optional budget
+class MemoryTracker {
+public:
+    void Add(MemoryCategory category, int64_t delta) {
+        size_t& bytes = m_bytes[static_cast<size_t>(category)];
+        bytes = static_cast<size_t>(static_cast<int64_t>(bytes) + delta);
+    }
+    void Set(MemoryCategory category, size_t bytes) { m_bytes[static_cast<size_t>(category)] = bytes; }
+    size_t Get(MemoryCategory category) const { return m_bytes[static_cast<size_t>(category)]; }
+
+    size_t GetTotal() const {
+        size_t total = 0;
+        for (size_t bytes : m_bytes) {
+            total += bytes;
+        }
+        return total;
+    }
+
+    // A budget of 0 means unlimited
+    void SetBudget(size_t bytes) { m_budget = bytes; }
+    size_t GetBudget() const { return m_budget; }
+    bool IsOverBudget() const { return m_budget > 0 && GetTotal() > m_budget; }
+    bool HasHeadroom(float fraction) const {
+        return m_budget == 0 || static_cast<double>(GetTotal()) < static_cast<double>(m_budget) * fraction;
+    }
+
+private:
+    std::array<size_t, static_cast<size_t>(MemoryCategory::Count)> m_bytes{};
+    size_t m_budget = 0;
+};
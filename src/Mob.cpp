@@ -1,8 +1,14 @@
 #include "Mob.h"
 #include "Chunk.h"
+#include "World.h"
 #include <random>
 #include <cmath>
 
+namespace {
+    // Blocks a mob can climb in one step
+    const int kMaxStepUp = 1;
+}
+
 Mob::Mob(MobType type, const Vector3& position)
     : m_type(type)
     , m_position(position)
@@ -16,15 +22,27 @@ Mob::Mob(MobType type, const Vector3& position)
 Mob::~Mob() {
 }
 
-void Mob::Update(float deltaTime) {
+void Mob::Update(float deltaTime, const World* world) {
     UpdateAI(deltaTime);
 
     // Apply movement
+    Vector3 previous = m_position;
     m_position = m_position + m_velocity * deltaTime;
 
-    // Simple ground detection
-    if (m_position.y < 70.0f) {
-        m_position.y = 70.0f;
+    // Stand on the ground below the mob's feet, not on a canopy or overhang
+    // above it: step up at most one block, drop down any height
+    if (world) {
+        int feetY = static_cast<int>(std::floor(m_position.y));
+        int groundHeight = world->GetGroundHeight(static_cast<int>(std::floor(m_position.x)),
+                                                  static_cast<int>(std::floor(m_position.z)),
+                                                  feetY + kMaxStepUp);
+        if (groundHeight < 0 || groundHeight >= feetY + kMaxStepUp) {
+            // No ground at all, or a wall: stay put and wander elsewhere
+            m_position = previous;
+            m_wanderTimer = 0;
+        } else {
+            m_position.y = static_cast<float>(groundHeight + 1);
+        }
         m_velocity.y = 0;
     }
 }
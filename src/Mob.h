@@ -8,6 +8,8 @@
 
 using Microsoft::WRL::ComPtr;
 
+class World;
+
 enum class MobType {
     Cow
 };
@@ -17,7 +19,7 @@ public:
     Mob(MobType type, const Vector3& position);
     ~Mob();
 
-    void Update(float deltaTime);
+    void Update(float deltaTime, const World* world);
     void Render(ID3D11DeviceContext* context);
 
     void CreateMesh(ID3D11Device* device);
@@ -3,9 +3,13 @@
 #include "World.h"
 #include "SoundSystem.h"
 #include <algorithm>
+#include <cmath>
 #include <vector>
 
 const float PI = 3.14159265359f;
+// Velocity smoothing rate (1/s): the reported velocity follows about the
+// last quarter second of movement
+const float kVelocitySmoothing = 4.0f;
 
 Player::Player()
     : m_position(0, 100, 0)
@@ -43,7 +47,12 @@ Player::Player()
 
 void Player::Update(float deltaTime, Window* window, World* world, SoundSystem* soundSystem) {
     UpdateLook(deltaTime, window);
+    Vector3 previousPosition = m_position;
     UpdateMovement(deltaTime, window, world, soundSystem);
+    if (deltaTime > 0.0f) {
+        Vector3 frameVelocity = (m_position - previousPosition) / deltaTime;
+        m_velocity = m_velocity + (frameVelocity - m_velocity) * std::min(deltaTime * kVelocitySmoothing, 1.0f);
+    }
     UpdateBlockInteraction(window, world, soundSystem);
 
     // Update camera
@@ -134,14 +143,21 @@ void Player::UpdateMovement(float deltaTime, Window* window, World* world, Sound
         m_verticalVelocity += m_gravity * deltaTime;
         m_position.y += m_verticalVelocity * deltaTime;
 
-        // Ground check via raycast
+        // Ground check: the highest opaque block in the column below the
+        // eye, within reach of the feet
         const float playerHeight = 1.7f;
-        Vector3 hitPos, hitNormal;
-        Block hitBlock;
-        bool hitGround = world && world->Raycast(m_position, Vector3(0, -1, 0), playerHeight + 0.3f, hitPos, hitNormal, hitBlock);
+        int blockX = static_cast<int>(std::floor(m_position.x));
+        int blockZ = static_cast<int>(std::floor(m_position.z));
+        int topY = static_cast<int>(std::floor(m_position.y - 0.1f));
+        int bottomY = static_cast<int>(std::floor(m_position.y - (playerHeight + 0.3f)));
+        int groundBlockY = bottomY - 1;
+        if (world) {
+            groundBlockY = world->GetRegion(blockX, blockZ).FindTopOpaque(blockX, blockZ, bottomY, topY);
+        }
+        bool hitGround = groundBlockY >= bottomY;
 
         if (hitGround) {
-            float groundY = hitPos.y + 1.0f + playerHeight;
+            float groundY = groundBlockY + 1.0f + playerHeight;
             if (m_position.y <= groundY) {
                 m_position.y = groundY;
                 m_verticalVelocity = 0.0f;
@@ -217,12 +233,17 @@ void Player::UpdateBlockInteraction(Window* window, World* world, SoundSystem* s
             BlockType selected = GetSelectedBlock();
             if (selected != BlockType::Air) {
                 Vector3 placePos = hitPos + hitNormal;
-                world->SetBlock(
-                    static_cast<int>(placePos.x),
-                    static_cast<int>(placePos.y),
-                    static_cast<int>(placePos.z),
-                    selected
-                );
+                int placeX = static_cast<int>(placePos.x);
+                int placeY = static_cast<int>(placePos.y);
+                int placeZ = static_cast<int>(placePos.z);
+                world->SetBlock(placeX, placeY, placeZ, selected);
+
+                // Player-placed leaves never decay; torches remember the face they hang on
+                if (selected == BlockType::Leaves) {
+                    world->SetBlockState(placeX, placeY, placeZ, 1);
+                } else if (selected == BlockType::Torch) {
+                    world->SetBlockState(placeX, placeY, placeZ, GetTorchState(hitNormal));
+                }
                 if (soundSystem) {
                     soundSystem->PlaySound(SoundSystem::SOUND_BLOCK_PLACE);
                 }
@@ -234,6 +255,18 @@ void Player::UpdateBlockInteraction(Window* window, World* world, SoundSystem* s
     m_rightClickPressed = rightClick;
 }
 
+BlockState Player::GetTorchState(const Vector3& hitNormal) {
+    // The placed torch is attached to the face it was placed against, stored
+    // as BlockFace + 1 so that 0 stays the default (standing) state
+    BlockFace::Face face = BlockFace::Top;
+    if (hitNormal.z > 0.5f) face = BlockFace::Front;
+    else if (hitNormal.z < -0.5f) face = BlockFace::Back;
+    else if (hitNormal.x < -0.5f) face = BlockFace::Left;
+    else if (hitNormal.x > 0.5f) face = BlockFace::Right;
+    else if (hitNormal.y < -0.5f) face = BlockFace::Bottom;
+    return static_cast<BlockState>(face + 1);
+}
+
 BlockType Player::GetSelectedBlock() const {
     return m_inventory[m_selectedSlot];
 }
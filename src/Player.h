@@ -19,6 +19,8 @@ public:
 
     Vector3 GetPosition() const { return m_position; }
     void SetPosition(const Vector3& pos) { m_position = pos; }
+    // Smoothed over recent frames, in blocks/s
+    Vector3 GetVelocity() const { return m_velocity; }
 
     Camera& GetCamera() { return m_camera; }
 
@@ -37,6 +39,7 @@ private:
     void UpdateLook(float deltaTime, Window* window);
     void UpdateBlockInteraction(Window* window, World* world, SoundSystem* soundSystem);
     void AddBlockToInventory(BlockType type);
+    static BlockState GetTorchState(const Vector3& hitNormal);
 
     Vector3 m_position;
     Vector3 m_velocity;
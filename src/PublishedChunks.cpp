@@ -0,0 +1,194 @@
+#include "PublishedChunks.h"
+#include <algorithm>
+#include <bitset>
+#include <chrono>
+
+namespace {
+    using Clock = std::chrono::high_resolution_clock;
+
+    double ElapsedMs(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+}
+
+PublishedChunks::Subscription::Subscription(const PublishedChunks& published)
+    : m_published(published) {
+    m_published.m_subscribers++;
+}
+
+PublishedChunks::Subscription::~Subscription() {
+    m_published.m_subscribers--;
+}
+
+PublishedChunks::Reader::Reader(const PublishedChunks& published)
+    : m_guard(published.m_reclaimer)
+    , m_table(published.m_table.load()) {
+}
+
+const Chunk* PublishedChunks::Reader::FindChunk(int chunkX, int chunkZ) const {
+    if (!m_table) {
+        return nullptr;
+    }
+    uint64_t key = GetKey(chunkX, chunkZ);
+    const Bucket* bucket = (*m_table)[GetBucketIndex(key)];
+    if (!bucket) {
+        return nullptr;
+    }
+    for (const auto& entry : *bucket) {
+        if (entry.first == key) return entry.second;
+    }
+    return nullptr;
+}
+
+Block PublishedChunks::Reader::GetBlock(int worldX, int worldY, int worldZ) const {
+    if (worldY < 0 || worldY >= CHUNK_HEIGHT) {
+        return Block(BlockType::Air);
+    }
+    const Chunk* chunk = FindChunk(worldX >> DefaultChunkShape::SizeShift, worldZ >> DefaultChunkShape::SizeShift);
+    if (!chunk) {
+        return Block(BlockType::Air);
+    }
+    return chunk->GetBlock(worldX & DefaultChunkShape::SizeMask, worldY, worldZ & DefaultChunkShape::SizeMask);
+}
+
+PublishedChunks::PublishedChunks()
+    : m_table(nullptr)
+    , m_subscribers(0)
+    , m_publishes(0)
+    , m_copies(0)
+    , m_bucketCopies(0)
+    , m_publishMs(0.0) {
+}
+
+PublishedChunks::~PublishedChunks() {
+    // No reader may outlive the world; the copies go back to the pool here
+    m_table.store(nullptr);
+    m_retired.clear();
+    m_entries.clear();
+}
+
+void PublishedChunks::Publish(const ChunkGrid& chunks, MemoryTracker& memory) {
+    auto start = Clock::now();
+    if (m_subscribers.load() == 0) {
+        Clear(memory);
+    } else {
+        std::vector<ChunkPool::Handle> replaced;
+        // Keys whose copy was added, replaced or removed
+        std::vector<uint64_t> changedKeys;
+
+        // Copies of chunks that unloaded, or whose object now holds another chunk
+        for (auto it = m_entries.begin(); it != m_entries.end();) {
+            const Chunk* copy = it->second.copy.get();
+            if (chunks.Find(copy->GetChunkX(), copy->GetChunkZ()) != it->second.source) {
+                replaced.push_back(std::move(it->second.copy));
+                changedKeys.push_back(it->first);
+                it = m_entries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        // New copies of chunks loaded or edited since the last publish
+        chunks.ForEach([&](const Chunk* chunk) {
+            uint64_t key = GetKey(chunk->GetChunkX(), chunk->GetChunkZ());
+            Entry& entry = m_entries[key];
+            if (entry.copy && entry.source == chunk && entry.revision == chunk->GetRevision()) {
+                return;
+            }
+            if (entry.copy) {
+                replaced.push_back(std::move(entry.copy));
+            }
+            entry.copy = m_pool.Acquire(chunk->GetChunkX(), chunk->GetChunkZ());
+            entry.copy->CopyBlocksFrom(*chunk);
+            entry.copy->ReportMemory(memory);
+            entry.source = chunk;
+            entry.revision = chunk->GetRevision();
+            changedKeys.push_back(key);
+            m_copies++;
+        });
+
+        if (!changedKeys.empty()) {
+            // The new table shares every bucket but the changed ones
+            std::unique_ptr<Table> table(new Table());
+            if (m_ownedTable) {
+                *table = *m_ownedTable;
+            } else {
+                table->fill(nullptr);
+            }
+            std::bitset<kBucketCount> copied;
+            std::vector<std::unique_ptr<Bucket>> replacedBuckets;
+            for (uint64_t key : changedKeys) {
+                int index = GetBucketIndex(key);
+                std::unique_ptr<Bucket>& bucket = m_buckets[index];
+                if (!copied[index]) {
+                    copied.set(index);
+                    std::unique_ptr<Bucket> newBucket(bucket ? new Bucket(*bucket) : new Bucket());
+                    if (bucket) replacedBuckets.push_back(std::move(bucket));
+                    bucket = std::move(newBucket);
+                    m_bucketCopies++;
+                }
+                auto entry = m_entries.find(key);
+                auto slot = std::find_if(bucket->begin(), bucket->end(),
+                    [key](const Bucket::value_type& item) { return item.first == key; });
+                if (entry == m_entries.end()) {
+                    if (slot != bucket->end()) bucket->erase(slot);
+                } else if (slot != bucket->end()) {
+                    slot->second = entry->second.copy.get();
+                } else {
+                    bucket->emplace_back(key, entry->second.copy.get());
+                }
+                (*table)[index] = bucket->empty() ? nullptr : bucket.get();
+            }
+            m_table.store(table.get());
+            m_publishes++;
+
+            // Stamped after the swap: readers from this epoch on see the new table
+            uint64_t epoch = m_reclaimer.GetEpoch();
+            if (m_ownedTable) {
+                m_retired.push_back({ epoch, nullptr, std::move(m_ownedTable), nullptr });
+            }
+            m_ownedTable = std::move(table);
+            for (std::unique_ptr<Bucket>& bucket : replacedBuckets) {
+                m_retired.push_back({ epoch, nullptr, nullptr, std::move(bucket) });
+            }
+            for (ChunkPool::Handle& copy : replaced) {
+                copy->WithdrawMemory(memory);
+                m_retired.push_back({ epoch, std::move(copy), nullptr, nullptr });
+            }
+        }
+    }
+
+    uint64_t safeEpoch = m_reclaimer.Advance();
+    m_retired.erase(std::remove_if(m_retired.begin(), m_retired.end(),
+        [safeEpoch](const Retired& retired) { return retired.epoch < safeEpoch; }), m_retired.end());
+    m_publishMs += ElapsedMs(start);
+}
+
+void PublishedChunks::Clear(MemoryTracker& memory) {
+    if (!m_ownedTable) {
+        return;
+    }
+    m_table.store(nullptr);
+    uint64_t epoch = m_reclaimer.GetEpoch();
+    m_retired.push_back({ epoch, nullptr, std::move(m_ownedTable), nullptr });
+    for (std::unique_ptr<Bucket>& bucket : m_buckets) {
+        if (bucket) m_retired.push_back({ epoch, nullptr, nullptr, std::move(bucket) });
+    }
+    for (auto& entry : m_entries) {
+        entry.second.copy->WithdrawMemory(memory);
+        m_retired.push_back({ epoch, std::move(entry.second.copy), nullptr, nullptr });
+    }
+    m_entries.clear();
+}
+
+PublishedChunks::Stats PublishedChunks::GetStats() const {
+    Stats stats;
+    stats.chunkCount = m_entries.size();
+    stats.publishes = m_publishes;
+    stats.copies = m_copies;
+    stats.bucketCopies = m_bucketCopies;
+    stats.retiredCount = m_retired.size();
+    stats.subscribers = m_subscribers.load();
+    stats.publishMs = m_publishMs;
+    return stats;
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include "ChunkGrid.h"
+#include "ChunkPool.h"
+#include "EpochReclaimer.h"
+#include "MemoryTracker.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Read-only copies of the loaded chunks for threads other than the owner's
+// (generation, meshing, AI). After each update the owner copies chunks that
+// were loaded or edited (cheap: sections share storage copy-on-write) and
+// swaps in a new lookup table. The table is persistent: buckets of nearby
+// chunks behind a small array of pointers, so a publish copies the array
+// and just the buckets that changed. Readers use the table and copies
+// without locks; replaced ones are freed once no reader can still see them.
+// Nothing is published while no reader is subscribed.
+class PublishedChunks {
+    // Chunks of a 4x4 area (and of the areas 64 chunks apart that alias it)
+    static const int kBucketCount = 256;
+    using Bucket = std::vector<std::pair<uint64_t, const Chunk*>>;
+    using Table = std::array<const Bucket*, kBucketCount>;
+
+public:
+    struct Stats {
+        size_t chunkCount = 0;
+        uint64_t publishes = 0;
+        uint64_t copies = 0;
+        uint64_t bucketCopies = 0;
+        size_t retiredCount = 0;
+        int subscribers = 0;
+        // Owner-thread time spent in Publish
+        double publishMs = 0.0;
+    };
+
+    // Held by a reading thread for as long as it may read: while there are
+    // none, Publish does nothing and drops what it published. Publishing
+    // resumes at the owner's next update, so readers see an empty world
+    // until then.
+    class Subscription {
+    public:
+        explicit Subscription(const PublishedChunks& published);
+        ~Subscription();
+
+        Subscription(const Subscription&) = delete;
+        Subscription& operator=(const Subscription&) = delete;
+
+    private:
+        const PublishedChunks& m_published;
+    };
+
+    // A consistent view of the world as of one publish, from any thread.
+    // Chunks it returns stay valid while it lives, even if they unload.
+    class Reader {
+    public:
+        explicit Reader(const PublishedChunks& published);
+
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        const Chunk* FindChunk(int chunkX, int chunkZ) const;
+        // Air outside the world and in chunks that are not loaded
+        Block GetBlock(int worldX, int worldY, int worldZ) const;
+
+    private:
+        EpochReclaimer::Guard m_guard;
+        const Table* m_table;
+    };
+
+    PublishedChunks();
+    ~PublishedChunks();
+
+    PublishedChunks(const PublishedChunks&) = delete;
+    PublishedChunks& operator=(const PublishedChunks&) = delete;
+
+    // Owner thread only: copies what changed since the last call and frees
+    // what readers are done with. Copies count toward the block data memory.
+    void Publish(const ChunkGrid& chunks, MemoryTracker& memory);
+    Stats GetStats() const;
+
+private:
+    static uint64_t GetKey(int chunkX, int chunkZ) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(chunkX)) << 32) | static_cast<uint32_t>(chunkZ);
+    }
+    static int GetBucketIndex(uint64_t key) {
+        return static_cast<int>(((key >> 34) & 15) << 4 | ((key >> 2) & 15));
+    }
+    // Unpublishes everything, for when the last subscriber has gone
+    void Clear(MemoryTracker& memory);
+
+    struct Entry {
+        ChunkPool::Handle copy;
+        // The live chunk and its revision when copied
+        const Chunk* source = nullptr;
+        uint32_t revision = 0;
+    };
+
+    // Unpublished, freed once its epoch is safe
+    struct Retired {
+        uint64_t epoch;
+        ChunkPool::Handle copy;
+        std::unique_ptr<Table> table;
+        std::unique_ptr<Bucket> bucket;
+    };
+
+    // Declared first so it outlives every copy it hands out
+    ChunkPool m_pool;
+    EpochReclaimer m_reclaimer;
+    std::atomic<const Table*> m_table;
+    std::unique_ptr<Table> m_ownedTable;
+    std::array<std::unique_ptr<Bucket>, kBucketCount> m_buckets;
+    std::unordered_map<uint64_t, Entry> m_entries;
+    std::vector<Retired> m_retired;
+    mutable std::atomic<int> m_subscribers;
+    uint64_t m_publishes;
+    uint64_t m_copies;
+    uint64_t m_bucketCopies;
+    double m_publishMs;
+};
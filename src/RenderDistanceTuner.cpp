@@ -0,0 +1,121 @@
+#include "RenderDistanceTuner.h"
+#include <algorithm>
+
+namespace {
+    // Time constant of the frame time averages
+    const float kSmoothingSeconds = 0.5f;
+    // Raising needs frames at or under target * kRaiseSlack, lowering only
+    // frames over the target itself; in between the distance holds, so a
+    // raise that lands just under the target is not undone right away
+    const float kRaiseSlack = 0.9f;
+    const float kLowerAfterSeconds = 1.0f;
+    const float kRaiseAfterSeconds = 3.0f;
+    // No judgment right after a change, while the new ring loads or unloads
+    const float kSettleSeconds = 2.0f;
+    const float kInitialRetryDelay = 10.0f;
+    const float kMaxRetryDelay = 120.0f;
+}
+
+RenderDistanceTuner::RenderDistanceTuner(int distance, int minDistance, int maxDistance, float targetFps)
+    : m_distance(std::min(std::max(distance, minDistance), maxDistance))
+    , m_minDistance(minDistance)
+    , m_maxDistance(maxDistance)
+    , m_targetMs(1000.0f / targetFps)
+    , m_reason(Reason::Startup)
+    , m_frameMs(0.0f)
+    , m_loadMs(0.0f)
+    , m_haveSample(false)
+    , m_sinceChange(0.0f)
+    , m_overSeconds(0.0f)
+    , m_meetSeconds(0.0f)
+    , m_failedDistance(maxDistance + 1)
+    , m_sinceFailure(0.0f)
+    , m_retryDelay(kInitialRetryDelay) {
+}
+
+const char* RenderDistanceTuner::GetReasonText() const {
+    switch (m_reason) {
+    case Reason::Startup:    return "startup";
+    case Reason::Holding:    return "holding";
+    case Reason::Loading:    return "loading";
+    case Reason::OverTarget: return "over target";
+    case Reason::Headroom:   return "headroom";
+    case Reason::BackedOff:  return "backed off";
+    case Reason::AtMinimum:  return "at minimum";
+    case Reason::AtMaximum:  return "at maximum";
+    default:                 return "";
+    }
+}
+
+void RenderDistanceTuner::Change(int delta, Reason reason) {
+    if (delta < 0) {
+        // Back off further each time the same distance fails again
+        m_retryDelay = m_distance == m_failedDistance ? std::min(m_retryDelay * 2.0f, kMaxRetryDelay)
+                                                      : kInitialRetryDelay;
+        m_failedDistance = m_distance;
+        m_sinceFailure = 0.0f;
+    }
+    m_distance += delta;
+    m_reason = reason;
+    m_sinceChange = 0.0f;
+    m_overSeconds = 0.0f;
+    m_meetSeconds = 0.0f;
+}
+
+bool RenderDistanceTuner::Update(float frameSeconds, float loadMs, bool loading) {
+    float frameMs = frameSeconds * 1000.0f;
+    float alpha = m_haveSample ? std::min(frameSeconds / kSmoothingSeconds, 1.0f) : 1.0f;
+    m_frameMs += (frameMs - m_frameMs) * alpha;
+    m_loadMs += (loadMs - m_loadMs) * alpha;
+    m_haveSample = true;
+
+    m_sinceChange += frameSeconds;
+    m_sinceFailure += frameSeconds;
+    // The last reason stays up while settling
+    if (m_sinceChange < kSettleSeconds) {
+        return false;
+    }
+
+    bool over = m_frameMs > m_targetMs;
+    bool meeting = m_frameMs <= m_targetMs * kRaiseSlack;
+    m_overSeconds = over ? m_overSeconds + frameSeconds : 0.0f;
+    m_meetSeconds = meeting ? m_meetSeconds + frameSeconds : 0.0f;
+
+    if (over) {
+        // Loading is budgeted and temporary; only the rest of the frame
+        // scales with the distance
+        if (loading && m_frameMs - m_loadMs <= m_targetMs) {
+            m_reason = Reason::Loading;
+            return false;
+        }
+        if (m_overSeconds < kLowerAfterSeconds) {
+            m_reason = Reason::Holding;
+            return false;
+        }
+        if (m_distance <= m_minDistance) {
+            m_reason = Reason::AtMinimum;
+            return false;
+        }
+        Change(-1, Reason::OverTarget);
+        return true;
+    }
+
+    if (!meeting || m_meetSeconds < kRaiseAfterSeconds) {
+        m_reason = Reason::Holding;
+        return false;
+    }
+    if (loading) {
+        m_reason = Reason::Loading;
+        return false;
+    }
+    if (m_distance >= m_maxDistance) {
+        m_reason = Reason::AtMaximum;
+        return false;
+    }
+    if (m_distance + 1 >= m_failedDistance && m_sinceFailure < m_retryDelay) {
+        m_reason = Reason::BackedOff;
+        return false;
+    }
+    Change(1, Reason::Headroom);
+    return true;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+// Picks the render distance from measured frame times so the game holds a
+// target frame rate. It lowers the distance once frames have missed the
+// target for a while and raises it once they have been well under it for
+// longer, waiting for the world to settle after every change. A distance
+// that had to be lowered is retried only after a back-off that doubles on
+// each failure, so it settles on the largest distance that holds the target
+// instead of oscillating. With vsync, where frame time shows no headroom,
+// it only ever lowers.
+class RenderDistanceTuner {
+public:
+    enum class Reason {
+        Startup,
+        Holding,     // Near the target: no reason to move
+        Loading,     // Over target only because chunks are streaming in
+        OverTarget,  // Lowered
+        Headroom,    // Raised
+        BackedOff,   // Would raise, but that distance failed recently
+        AtMinimum,
+        AtMaximum
+    };
+
+    RenderDistanceTuner(int distance, int minDistance, int maxDistance, float targetFps = 60.0f);
+
+    void SetTargetFps(float fps) { m_targetMs = 1000.0f / fps; }
+    float GetTargetMs() const { return m_targetMs; }
+
+    // Feeds one frame: its total time, and the part spent in chunk loading
+    // stages, plus whether chunks are still being loaded. Returns whether
+    // the distance changed.
+    bool Update(float frameSeconds, float loadMs, bool loading);
+
+    int GetDistance() const { return m_distance; }
+    Reason GetReason() const { return m_reason; }
+    const char* GetReasonText() const;
+    float GetSmoothedFrameMs() const { return m_frameMs; }
+
+private:
+    void Change(int delta, Reason reason);
+
+    int m_distance;
+    int m_minDistance;
+    int m_maxDistance;
+    float m_targetMs;
+    Reason m_reason;
+
+    // Exponential moving averages
+    float m_frameMs;
+    float m_loadMs;
+    bool m_haveSample;
+
+    float m_sinceChange;
+    float m_overSeconds;
+    float m_meetSeconds;
+
+    // Lowest distance that missed the target, and when it may be retried
+    int m_failedDistance;
+    float m_sinceFailure;
+    float m_retryDelay;
+};
@@ -357,6 +357,20 @@ bool Renderer::CompileShaders() {
     hr = m_device->CreateInputLayout(layout, 4, vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), &m_inputLayout);
     if (FAILED(hr)) return false;
 
+    // Chunk quads: one 8-byte MeshQuad per instance, expanded by the shader
+    if (!CompileShaderFromFile("shaders/ChunkQuadVertex.hlsl", "main", "vs_5_0", &vsBlob)) return false;
+
+    hr = m_device->CreateVertexShader(vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), nullptr, &m_chunkQuadVS);
+    if (FAILED(hr)) return false;
+
+    D3D11_INPUT_ELEMENT_DESC quadLayout[] = {
+        { "QUADBLOCK", 0, DXGI_FORMAT_R8G8B8A8_UINT, 0, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+        { "QUADINFO", 0, DXGI_FORMAT_R8G8B8A8_UINT, 0, 4, D3D11_INPUT_PER_INSTANCE_DATA, 1 }
+    };
+
+    hr = m_device->CreateInputLayout(quadLayout, 2, vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), &m_chunkQuadInputLayout);
+    if (FAILED(hr)) return false;
+
     // Shadow shaders
     if (!CompileShaderFromFile("shaders/ShadowVertex.hlsl", "main", "vs_5_0", &vsBlob)) return false;
     if (!CompileShaderFromFile("shaders/ShadowPixel.hlsl", "main", "ps_5_0", &psBlob)) return false;
@@ -399,6 +413,22 @@ bool Renderer::CreateConstantBuffers() {
 
     cbDesc.ByteWidth = 64; // For UI orthographic matrix
     hr = m_device->CreateBuffer(&cbDesc, nullptr, &m_uiConstantBuffer);
+    if (FAILED(hr)) return false;
+
+    // Block colors for the chunk quad shader, which looks them up by type
+    Vector4 blockColors[static_cast<size_t>(BlockType::Count)];
+    for (size_t type = 0; type < static_cast<size_t>(BlockType::Count); type++) {
+        blockColors[type] = BlockDatabase::GetProperties(static_cast<BlockType>(type)).color;
+    }
+
+    D3D11_BUFFER_DESC colorDesc = {};
+    colorDesc.Usage = D3D11_USAGE_IMMUTABLE;
+    colorDesc.ByteWidth = sizeof(blockColors);
+    colorDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+
+    D3D11_SUBRESOURCE_DATA colorInit = {};
+    colorInit.pSysMem = blockColors;
+    hr = m_device->CreateBuffer(&colorDesc, &colorInit, &m_blockColorBuffer);
     return SUCCEEDED(hr);
 }
 
@@ -587,10 +617,10 @@ void Renderer::RenderWorld(World* world, Camera& camera) {
     // Set rasterizer state
     m_context->RSSetState(m_solidRasterizer.Get());
 
-    // Set shaders
-    m_context->VSSetShader(m_blockVS.Get(), nullptr, 0);
+    // Set shaders; chunks draw their quads through the quad shader
+    m_context->VSSetShader(m_chunkQuadVS.Get(), nullptr, 0);
     m_context->PSSetShader(m_blockPS.Get(), nullptr, 0);
-    m_context->IASetInputLayout(m_inputLayout.Get());
+    m_context->IASetInputLayout(m_chunkQuadInputLayout.Get());
 
     // Set samplers
     m_context->PSSetSamplers(0, 1, m_linearSampler.GetAddressOf());
@@ -605,6 +635,7 @@ void Renderer::RenderWorld(World* world, Camera& camera) {
 
     m_context->VSSetConstantBuffers(0, 1, m_constantBuffer.GetAddressOf());
     m_context->PSSetConstantBuffers(0, 1, m_constantBuffer.GetAddressOf());
+    m_context->VSSetConstantBuffers(2, 1, m_blockColorBuffer.GetAddressOf());
 
     // Render world
     world->Render(m_context.Get());
@@ -616,9 +647,11 @@ void Renderer::RenderWorld(World* world, Camera& camera) {
 
     world->RenderTransparent(m_context.Get(), camera.GetPosition());
 
-    // Reset states
+    // Reset states; mobs and the player draw plain vertices
     m_context->OMSetBlendState(nullptr, blendFactor, 0xFFFFFFFF);
     m_context->OMSetDepthStencilState(nullptr, 0);
+    m_context->VSSetShader(m_blockVS.Get(), nullptr, 0);
+    m_context->IASetInputLayout(m_inputLayout.Get());
 }
 
 void Renderer::RenderMob(Mob* mob, Camera& camera) {
@@ -799,8 +832,8 @@ void Renderer::RenderDebugHUD(const DebugInfo& debugInfo) {
     std::vector<uint32_t> indices;
 
     // Draw semi-transparent background
-    float bgWidth = 350.0f;
-    float bgHeight = (debugInfo.dxrStatus || debugInfo.dxrError) ? 140.0f : 100.0f;
+    float bgWidth = 420.0f;
+    float bgHeight = (debugInfo.dxrStatus || debugInfo.dxrError) ? 200.0f : 160.0f;
     float bgX = 10.0f;
     float bgY = 10.0f;
 
@@ -835,27 +868,50 @@ void Renderer::RenderDebugHUD(const DebugInfo& debugInfo) {
     DrawText(chunkText, 15.0f, 35.0f, 2.0f, Vector4(0.9f, 0.9f, 0.9f, 1.0f), vertices, indices);
 
     char indexText[128];
-    sprintf(indexText, "Idx: %llu / %llu",
+    sprintf(indexText, "Idx: %llu / %llu (%s)",
             static_cast<unsigned long long>(debugInfo.solidIndexCount),
-            static_cast<unsigned long long>(debugInfo.transparentIndexCount));
+            static_cast<unsigned long long>(debugInfo.transparentIndexCount),
+            debugInfo.meshMode ? debugInfo.meshMode : "per-face");
     DrawText(indexText, 15.0f, 55.0f, 2.0f, Vector4(0.9f, 0.9f, 0.9f, 1.0f), vertices, indices);
 
+    // Draw memory accounting (MB)
+    const double mb = 1.0 / (1024.0 * 1024.0);
+    char memoryText[128];
+    sprintf(memoryText, "Mem: %.0f / %.0f MB",
+            (debugInfo.memoryBlockBytes + debugInfo.memoryCpuMeshBytes +
+             debugInfo.memoryGpuMeshBytes + debugInfo.memoryColdCacheBytes) * mb,
+            debugInfo.memoryBudgetBytes * mb);
+    DrawText(memoryText, 15.0f, 75.0f, 2.0f, Vector4(0.9f, 0.9f, 0.9f, 1.0f), vertices, indices);
+
+    char memoryDetailText[128];
+    sprintf(memoryDetailText, "Blk %.0f Cpu %.0f Gpu %.0f Cold %.0f",
+            debugInfo.memoryBlockBytes * mb, debugInfo.memoryCpuMeshBytes * mb,
+            debugInfo.memoryGpuMeshBytes * mb, debugInfo.memoryColdCacheBytes * mb);
+    DrawText(memoryDetailText, 15.0f, 95.0f, 2.0f, Vector4(0.7f, 0.7f, 0.7f, 1.0f), vertices, indices);
+
+    // Draw render distance and why the tuner chose it
+    char viewText[128];
+    sprintf(viewText, "View: %d (%s) %.1f / %.1f ms", debugInfo.renderDistance,
+            debugInfo.renderDistanceReason ? debugInfo.renderDistanceReason : "fixed",
+            debugInfo.frameMs, debugInfo.targetFrameMs);
+    DrawText(viewText, 15.0f, 115.0f, 2.0f, Vector4(0.9f, 0.9f, 0.9f, 1.0f), vertices, indices);
+
     // Draw looked-at block info
     if (debugInfo.hasLookedAtBlock) {
         const char* blockName = BlockDatabase::GetProperties(debugInfo.lookedAtBlockType).name;
         char blockText[128];
         sprintf(blockText, "Looking at: %s", blockName);
-        DrawText(blockText, 15.0f, 75.0f, 2.0f, Vector4(1.0f, 1.0f, 0.8f, 1.0f), vertices, indices);
+        DrawText(blockText, 15.0f, 135.0f, 2.0f, Vector4(1.0f, 1.0f, 0.8f, 1.0f), vertices, indices);
     } else {
-        DrawText("Looking at: Nothing", 15.0f, 75.0f, 2.0f, Vector4(0.7f, 0.7f, 0.7f, 1.0f), vertices, indices);
+        DrawText("Looking at: Nothing", 15.0f, 135.0f, 2.0f, Vector4(0.7f, 0.7f, 0.7f, 1.0f), vertices, indices);
     }
 
     // Draw DXR status if available
     if (debugInfo.dxrStatus) {
-        DrawText(debugInfo.dxrStatus, 15.0f, 95.0f, 2.0f, Vector4(0.5f, 0.8f, 1.0f, 1.0f), vertices, indices);
+        DrawText(debugInfo.dxrStatus, 15.0f, 155.0f, 2.0f, Vector4(0.5f, 0.8f, 1.0f, 1.0f), vertices, indices);
     }
     if (debugInfo.dxrError && debugInfo.dxrError[0] != '\0') {
-        DrawText(debugInfo.dxrError, 15.0f, 115.0f, 2.0f, Vector4(1.0f, 0.4f, 0.4f, 1.0f), vertices, indices);
+        DrawText(debugInfo.dxrError, 15.0f, 175.0f, 2.0f, Vector4(1.0f, 0.4f, 0.4f, 1.0f), vertices, indices);
     }
 
     if (vertices.empty()) return;
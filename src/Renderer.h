@@ -23,6 +23,16 @@ struct DebugInfo {
     int loadedChunkCount;
     uint64_t solidIndexCount;
     uint64_t transparentIndexCount;
+    const char* meshMode = nullptr;
+    size_t memoryBlockBytes = 0;
+    size_t memoryCpuMeshBytes = 0;
+    size_t memoryGpuMeshBytes = 0;
+    size_t memoryColdCacheBytes = 0;
+    size_t memoryBudgetBytes = 0;
+    int renderDistance = 0;
+    const char* renderDistanceReason = nullptr;
+    float frameMs = 0.0f;
+    float targetFrameMs = 0.0f;
     const char* dxrStatus = nullptr;
     const char* dxrError = nullptr;
 };
@@ -102,6 +112,7 @@ private:
 
     // Shaders
     ComPtr<ID3D11VertexShader> m_blockVS;
+    ComPtr<ID3D11VertexShader> m_chunkQuadVS;
     ComPtr<ID3D11PixelShader> m_blockPS;
     ComPtr<ID3D11VertexShader> m_shadowVS;
     ComPtr<ID3D11PixelShader> m_shadowPS;
@@ -109,10 +120,12 @@ private:
     ComPtr<ID3D11PixelShader> m_uiPS;
 
     ComPtr<ID3D11InputLayout> m_inputLayout;
+    ComPtr<ID3D11InputLayout> m_chunkQuadInputLayout;
     ComPtr<ID3D11InputLayout> m_uiInputLayout;
 
     ComPtr<ID3D11Buffer> m_constantBuffer;
     ComPtr<ID3D11Buffer> m_uiConstantBuffer;
+    ComPtr<ID3D11Buffer> m_blockColorBuffer;
 
     ComPtr<ID3D11SamplerState> m_linearSampler;
     ComPtr<ID3D11SamplerState> m_shadowSampler;
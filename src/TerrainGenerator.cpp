@@ -1,7 +1,15 @@
 #include "TerrainGenerator.h"
+#include "BlockAccessor.h"
 #include "Chunk.h"
+#include <algorithm>
 #include <cmath>
 
+namespace {
+    // Trees sit on a 4-block grid inside each 16x16 cell, so every chunk
+    // shape grows the same forest
+    const int kTreeCell = 16;
+}
+
 TerrainGenerator::TerrainGenerator(unsigned int seed)
     : m_heightNoise(seed)
     , m_moistureNoise(seed + 1)
@@ -25,47 +33,55 @@ float TerrainGenerator::GetMoisture(int worldX, int worldZ) const {
     return noiseValue * 0.5f + 0.5f; // Map to [0, 1]
 }
 
-void TerrainGenerator::GenerateChunk(Chunk* chunk) {
+template <typename ChunkT>
+void TerrainGenerator::GenerateChunk(ChunkT* chunk) const {
     GenerateTerrain(chunk);
     GenerateTrees(chunk);
     GenerateWater(chunk);
+    chunk->CompactSections();
 }
 
-void TerrainGenerator::GenerateTerrain(Chunk* chunk) {
+template <typename ChunkT>
+void TerrainGenerator::GenerateTerrain(ChunkT* chunk) const {
     Vector3 chunkWorldPos = chunk->GetWorldPosition();
+    int baseY = static_cast<int>(chunkWorldPos.y);
 
-    for (int x = 0; x < CHUNK_SIZE; x++) {
-        for (int z = 0; z < CHUNK_SIZE; z++) {
+    for (int x = 0; x < ChunkT::Size; x++) {
+        for (int z = 0; z < ChunkT::Size; z++) {
             int worldX = static_cast<int>(chunkWorldPos.x) + x;
             int worldZ = static_cast<int>(chunkWorldPos.z) + z;
 
-            int height = GetTerrainHeight(worldX, worldZ);
+            // Terrain height relative to this chunk's bottom
+            int height = GetTerrainHeight(worldX, worldZ) - baseY;
 
             // Generate stone base
-            for (int y = 0; y < height - 4 && y < CHUNK_HEIGHT; y++) {
+            for (int y = 0; y < height - 4 && y < ChunkT::Height; y++) {
                 chunk->SetBlock(x, y, z, BlockType::Stone);
             }
 
             // Dirt layer
-            for (int y = height - 4; y < height && y < CHUNK_HEIGHT; y++) {
-                if (y >= 0) {
-                    chunk->SetBlock(x, y, z, BlockType::Dirt);
-                }
+            for (int y = std::max(height - 4, 0); y < height && y < ChunkT::Height; y++) {
+                chunk->SetBlock(x, y, z, BlockType::Dirt);
             }
 
             // Top layer - grass represented as dirt for now
-            if (height >= 0 && height < CHUNK_HEIGHT) {
+            if (height >= 0 && height < ChunkT::Height) {
                 chunk->SetBlock(x, height, z, BlockType::Dirt);
             }
         }
     }
 }
 
-void TerrainGenerator::GenerateTrees(Chunk* chunk) {
+template <typename ChunkT>
+void TerrainGenerator::GenerateTrees(ChunkT* chunk) const {
     Vector3 chunkWorldPos = chunk->GetWorldPosition();
+    int baseY = static_cast<int>(chunkWorldPos.y);
+    BasicBlockAccessor<ChunkT> region(*chunk);
 
-    for (int x = 2; x < CHUNK_SIZE - 2; x += 4) {
-        for (int z = 2; z < CHUNK_SIZE - 2; z += 4) {
+    for (int x = 2; x < ChunkT::Size; x += 4) {
+        if (x % kTreeCell >= kTreeCell - 2) continue;
+        for (int z = 2; z < ChunkT::Size; z += 4) {
+            if (z % kTreeCell >= kTreeCell - 2) continue;
             int worldX = static_cast<int>(chunkWorldPos.x) + x;
             int worldZ = static_cast<int>(chunkWorldPos.z) + z;
 
@@ -75,57 +91,58 @@ void TerrainGenerator::GenerateTrees(Chunk* chunk) {
             // More trees in moist areas
             if (treeChance > 0.3f && moisture > 0.4f) {
                 int groundHeight = GetTerrainHeight(worldX, worldZ);
-                PlaceTree(chunk, x, groundHeight + 1, z);
+                PlaceTree(chunk, region, x, groundHeight + 1 - baseY, z);
             }
         }
     }
 }
 
-void TerrainGenerator::PlaceTree(Chunk* chunk, int x, int y, int z) {
+template <typename ChunkT>
+void TerrainGenerator::PlaceTree(ChunkT* chunk, const BasicBlockAccessor<ChunkT>& region, int x, int y, int z) const {
     int trunkHeight = 5;
 
-    // Trunk
-    for (int i = 0; i < trunkHeight && (y + i) < CHUNK_HEIGHT; i++) {
+    // Trunk (SetBlock ignores the part below a stacked chunk)
+    for (int i = 0; i < trunkHeight && (y + i) < ChunkT::Height; i++) {
         chunk->SetBlock(x, y + i, z, BlockType::Wood);
     }
 
-    // Leaves - simple spherical shape
+    // Leaves - simple spherical shape in the air of the box around the
+    // crown, clipped to this chunk
     int leafY = y + trunkHeight;
-    for (int dx = -2; dx <= 2; dx++) {
-        for (int dy = -2; dy <= 2; dy++) {
-            for (int dz = -2; dz <= 2; dz++) {
-                int lx = x + dx;
-                int ly = leafY + dy;
-                int lz = z + dz;
-
-                // Simple distance check for spherical leaves
-                if (dx * dx + dy * dy + dz * dz <= 8) {
-                    if (chunk->IsBlockInBounds(lx, ly, lz)) {
-                        Block existingBlock = chunk->GetBlock(lx, ly, lz);
-                        if (existingBlock.IsAir()) {
-                            chunk->SetBlock(lx, ly, lz, BlockType::Leaves);
-                        }
-                    }
-                }
-            }
+    int originX = chunk->GetChunkX() * ChunkT::Size;
+    int originZ = chunk->GetChunkZ() * ChunkT::Size;
+    BlockBox crown = {
+        originX + std::max(x - 2, 0), leafY - 2, originZ + std::max(z - 2, 0),
+        originX + std::min(x + 2, ChunkT::Size - 1), leafY + 2, originZ + std::min(z + 2, ChunkT::Size - 1)
+    };
+    region.ForEach(crown, [&](int worldX, int ly, int worldZ, BlockType type) {
+        int lx = worldX - originX;
+        int lz = worldZ - originZ;
+        int dx = lx - x;
+        int dy = ly - leafY;
+        int dz = lz - z;
+        if (type == BlockType::Air && dx * dx + dy * dy + dz * dz <= 8) {
+            chunk->SetBlock(lx, ly, lz, BlockType::Leaves);
         }
-    }
+    });
 }
 
-void TerrainGenerator::GenerateWater(Chunk* chunk) {
+template <typename ChunkT>
+void TerrainGenerator::GenerateWater(ChunkT* chunk) const {
     Vector3 chunkWorldPos = chunk->GetWorldPosition();
-    int waterLevel = 60;
+    int baseY = static_cast<int>(chunkWorldPos.y);
+    int waterLevel = 60 - baseY;
 
-    for (int x = 0; x < CHUNK_SIZE; x++) {
-        for (int z = 0; z < CHUNK_SIZE; z++) {
+    for (int x = 0; x < ChunkT::Size; x++) {
+        for (int z = 0; z < ChunkT::Size; z++) {
             int worldX = static_cast<int>(chunkWorldPos.x) + x;
             int worldZ = static_cast<int>(chunkWorldPos.z) + z;
 
-            int terrainHeight = GetTerrainHeight(worldX, worldZ);
+            int terrainHeight = GetTerrainHeight(worldX, worldZ) - baseY;
 
             // Fill below water level with water
             if (terrainHeight < waterLevel) {
-                for (int y = terrainHeight + 1; y <= waterLevel && y < CHUNK_HEIGHT; y++) {
+                for (int y = std::max(terrainHeight + 1, 0); y <= waterLevel && y < ChunkT::Height; y++) {
                     if (chunk->GetBlock(x, y, z).IsAir()) {
                         chunk->SetBlock(x, y, z, BlockType::Water);
                     }
@@ -134,3 +151,7 @@ void TerrainGenerator::GenerateWater(Chunk* chunk) {
         }
     }
 }
+
+template void TerrainGenerator::GenerateChunk(BasicChunk<ChunkShape16>* chunk) const;
+template void TerrainGenerator::GenerateChunk(BasicChunk<ChunkShape32>* chunk) const;
+template void TerrainGenerator::GenerateChunk(BasicChunk<ChunkShapeCubic32>* chunk) const;
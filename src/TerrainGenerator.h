@@ -2,21 +2,29 @@
 #include "PerlinNoise.h"
 #include "Block.h"
 
-class Chunk;
+template <typename ChunkT>
+class BasicBlockAccessor;
 
 class TerrainGenerator {
 public:
     TerrainGenerator(unsigned int seed = 12345);
 
     int GetTerrainHeight(int worldX, int worldZ) const;
-    void GenerateChunk(Chunk* chunk);
+    // Instantiated for every chunk shape in TerrainGenerator.cpp. Const and
+    // free of shared state, so worker threads may generate concurrently
+    template <typename ChunkT>
+    void GenerateChunk(ChunkT* chunk) const;
 
 private:
-    void GenerateTerrain(Chunk* chunk);
-    void GenerateTrees(Chunk* chunk);
-    void GenerateWater(Chunk* chunk);
-
-    void PlaceTree(Chunk* chunk, int worldX, int worldY, int worldZ);
+    template <typename ChunkT>
+    void GenerateTerrain(ChunkT* chunk) const;
+    template <typename ChunkT>
+    void GenerateTrees(ChunkT* chunk) const;
+    template <typename ChunkT>
+    void GenerateWater(ChunkT* chunk) const;
+
+    template <typename ChunkT>
+    void PlaceTree(ChunkT* chunk, const BasicBlockAccessor<ChunkT>& region, int x, int y, int z) const;
 
     float GetMoisture(int worldX, int worldZ) const;
 
@@ -1,98 +1,433 @@
 #include "World.h"
 #include <cmath>
 #include <algorithm>
+#include <iterator>
+#include <thread>
 #include <vector>
 
-World::World(unsigned int seed)
-    : m_terrainGenerator(seed)
-    , m_renderDistance(8) {
+static_assert(CHUNK_HEIGHT == WORLD_HEIGHT, "World streams full-height chunk columns");
+
+namespace {
+    const int kDefaultRenderDistance = 8;
+    // Chunks are unloaded this many chunks beyond the render distance
+    const int kUnloadMargin = 2;
+    const size_t kDefaultColdCacheBudget = 32 * 1024 * 1024;
+    const size_t kDefaultMemoryBudget = 1024 * 1024 * 1024;
+    // Fraction of the budget below which budget-evicted chunks may return
+    const float kBudgetHeadroom = 0.85f;
+    // Budget-evicted chunks readmitted per update once there is headroom
+    const int kBudgetReadmitPerUpdate = 4;
+    // cos(60 degrees): chunks within this horizontal cone count as visible
+    const float kVisibleConeCos = 0.5f;
+
+    // The horizontal neighbors, by the side of a chunk they share
+    struct NeighborOffset {
+        BlockFace::Face side;
+        int dx, dz;
+    };
+    const NeighborOffset kNeighborOffsets[] = {
+        { BlockFace::Front, 0, 1 },
+        { BlockFace::Back, 0, -1 },
+        { BlockFace::Left, -1, 0 },
+        { BlockFace::Right, 1, 0 },
+    };
+
+    // Squared distance from a point to the nearest block of a section
+    int DistanceSqToSection(int x, int y, int z, int baseX, int baseY, int baseZ) {
+        int dx = x - std::min(std::max(x, baseX), baseX + SECTION_MASK);
+        int dy = y - std::min(std::max(y, baseY), baseY + SECTION_MASK);
+        int dz = z - std::min(std::max(z, baseZ), baseZ + SECTION_MASK);
+        return dx * dx + dy * dy + dz * dz;
+    }
+
+    int GetDefaultWorkerThreads() {
+        // Leave a core for the main thread
+        return std::max(static_cast<int>(std::thread::hardware_concurrency()) - 1, 1);
+    }
+}
+
+World::World(unsigned int seed, int workerThreads)
+    : m_chunks(kDefaultRenderDistance + kUnloadMargin + ChunkPrefetchPolicy().maxLeadChunks)
+    , m_coldCache(kDefaultColdCacheBudget)
+    , m_terrainGenerator(seed)
+    , m_tickets(kUnloadMargin)
+    , m_workers(m_terrainGenerator, workerThreads < 0 ? GetDefaultWorkerThreads() : workerThreads)
+    , m_queuedEditsApplied(0)
+    , m_renderDistance(kDefaultRenderDistance)
+    , m_cpuMeshesRequired(true)
+    , m_meshMode(MeshMode::Bitmask)
+    , m_viewDirection(0, 0, 1)
+    , m_playerVelocity(0, 0, 0)
+    , m_visibleUnmeshed(0)
+    , m_lateChunks(0)
+    , m_playerChunkX(0)
+    , m_playerChunkZ(0)
+    , m_frameIndex(0)
+    , m_cpuMeshReleases(0)
+    , m_budgetEvictions(0) {
+    m_memory.SetBudget(kDefaultMemoryBudget);
 }
 
 World::~World() {
 }
 
-void World::GetChunkAndLocalCoords(int worldX, int worldZ, int& chunkX, int& chunkZ, int& localX, int& localZ) const {
-    chunkX = static_cast<int>(std::floor(static_cast<float>(worldX) / CHUNK_SIZE));
-    chunkZ = static_cast<int>(std::floor(static_cast<float>(worldZ) / CHUNK_SIZE));
+void World::SetPrefetchPolicy(const ChunkPrefetchPolicy& policy) {
+    m_scheduler.SetPrefetchPolicy(policy);
+    UpdateGridWindow();
+}
 
-    localX = worldX - chunkX * CHUNK_SIZE;
-    localZ = worldZ - chunkZ * CHUNK_SIZE;
+void World::SetRenderDistance(int distance) {
+    m_renderDistance = std::max(distance, 1);
+    UpdateGridWindow();
+}
 
-    if (localX < 0) localX += CHUNK_SIZE;
-    if (localZ < 0) localZ += CHUNK_SIZE;
+void World::SetMeshMode(MeshMode mode) {
+    if (mode == m_meshMode) {
+        return;
+    }
+    m_meshMode = mode;
+    // Also makes meshes still in flight in the old mode stale
+    m_chunks.ForEach([](Chunk* chunk) { chunk->MarkForMeshUpdate(); });
 }
 
-Chunk* World::GetChunk(int chunkX, int chunkZ) {
+World::ObserverId World::AddObserver(const Vector3& position, int radius, float weight) {
+    int chunkX = static_cast<int>(std::floor(position.x)) >> DefaultChunkShape::SizeShift;
+    int chunkZ = static_cast<int>(std::floor(position.z)) >> DefaultChunkShape::SizeShift;
+    return m_tickets.Add(chunkX, chunkZ, radius, weight);
+}
+
+void World::MoveObserver(ObserverId id, const Vector3& position) {
+    int chunkX = static_cast<int>(std::floor(position.x)) >> DefaultChunkShape::SizeShift;
+    int chunkZ = static_cast<int>(std::floor(position.z)) >> DefaultChunkShape::SizeShift;
+    m_tickets.Move(id, chunkX, chunkZ);
+}
+
+bool World::ShouldKeepChunk(int chunkX, int chunkZ) const {
+    return m_scheduler.ShouldKeep(chunkX, chunkZ, kUnloadMargin) || m_tickets.GetRefCount(chunkX, chunkZ) > 0;
+}
+
+void World::UpdateGridWindow() {
+    const ChunkPrefetchPolicy& policy = m_scheduler.GetPrefetchPolicy();
+    m_chunks.SetWindowRadius(m_renderDistance + kUnloadMargin + (policy.enabled ? policy.maxLeadChunks : 0));
+}
+
+void World::GetChunkAndLocalCoords(int worldX, int worldZ, int& chunkX, int& chunkZ, int& localX, int& localZ) const {
+    // Chunk sizes are powers of two; the arithmetic shift floors negatives
+    chunkX = worldX >> DefaultChunkShape::SizeShift;
+    chunkZ = worldZ >> DefaultChunkShape::SizeShift;
+
+    localX = worldX & DefaultChunkShape::SizeMask;
+    localZ = worldZ & DefaultChunkShape::SizeMask;
+}
+
+bool World::StartChunkLoad(int chunkX, int chunkZ) {
     auto key = std::make_pair(chunkX, chunkZ);
-    auto it = m_chunks.find(key);
-    if (it != m_chunks.end()) {
-        return it->second.get();
+    if (GetChunk(chunkX, chunkZ) || m_budgetEvicted.count(key) || m_generating.count(key) ||
+        m_workers.IsSaturated(ChunkWorkers::GenerateJob)) {
+        return false;
+    }
+
+    ChunkPool::Handle newChunk = m_chunkPool.Acquire(chunkX, chunkZ);
+    // Chunks seen before come back from the cold cache, edits included
+    if (m_coldCache.Load(*newChunk)) {
+        m_chunks.Insert(std::move(newChunk))->ReportMemory(m_memory);
+        MarkNeighborsForMeshUpdate(chunkX, chunkZ);
+        return true;
     }
-    return nullptr;
+
+    std::unique_ptr<ChunkWorkers::Job> job(new ChunkWorkers::Job());
+    job->type = ChunkWorkers::GenerateJob;
+    job->chunk = std::move(newChunk);
+    m_generating.insert(key);
+    m_workers.Submit(std::move(job));
+    return true;
 }
 
-Chunk* World::GetOrCreateChunk(int chunkX, int chunkZ) {
-    Chunk* chunk = GetChunk(chunkX, chunkZ);
-    if (chunk) {
-        return chunk;
+bool World::StartChunkMesh(Chunk* chunk) {
+    auto key = std::make_pair(chunk->GetChunkX(), chunk->GetChunkZ());
+    if (!chunk->NeedsMeshUpdate() || m_meshing.count(key) || m_workers.IsSaturated(ChunkWorkers::MeshJob)) {
+        return false;
+    }
+    // A first mesh waits for neighbors already being generated, which
+    // would otherwise remesh it as soon as they load
+    if (!chunk->HasMesh()) {
+        for (const auto& offset : kNeighborOffsets) {
+            if (m_generating.count(std::make_pair(key.first + offset.dx, key.second + offset.dz))) {
+                return false;
+            }
+        }
     }
 
-    auto newChunk = std::make_unique<Chunk>(chunkX, chunkZ);
-    m_terrainGenerator.GenerateChunk(newChunk.get());
-    newChunk->GenerateMesh();
-    // Note: Buffer creation will happen in World::Update when device is available
+    // The worker meshes a private copy, so the chunk stays editable and
+    // keeps drawing its old mesh until the new one is swapped in
+    std::unique_ptr<ChunkWorkers::Job> job(new ChunkWorkers::Job());
+    job->type = ChunkWorkers::MeshJob;
+    job->chunk = m_snapshotPool.Acquire(key.first, key.second);
+    job->chunk->CopyBlocksFrom(*chunk);
+    for (const auto& offset : kNeighborOffsets) {
+        job->chunk->CopyBorderFrom(offset.side, GetChunk(key.first + offset.dx, key.second + offset.dz));
+    }
+    job->target = chunk;
+    job->revision = chunk->GetRevision();
+    job->meshMode = m_meshMode;
+    m_meshing.insert(key);
+    m_workers.Submit(std::move(job));
+    return true;
+}
 
-    Chunk* chunkPtr = newChunk.get();
-    m_chunks[std::make_pair(chunkX, chunkZ)] = std::move(newChunk);
+void World::CollectCompletedJobs() {
+    m_completedJobs.clear();
+    m_workers.Drain(m_completedJobs);
+
+    for (auto& job : m_completedJobs) {
+        int chunkX = job->chunk->GetChunkX();
+        int chunkZ = job->chunk->GetChunkZ();
+        auto key = std::make_pair(chunkX, chunkZ);
+
+        if (job->type == ChunkWorkers::GenerateJob) {
+            m_generating.erase(key);
+            // Unneeded chunks just go back to the pool; generation is
+            // deterministic, so nothing is lost
+            if (ShouldKeepChunk(chunkX, chunkZ) && !m_budgetEvicted.count(key)) {
+                m_chunks.Insert(std::move(job->chunk))->ReportMemory(m_memory);
+                MarkNeighborsForMeshUpdate(chunkX, chunkZ);
+            }
+        } else {
+            m_meshing.erase(key);
+            // The chunk may have been edited, or unloaded and its object
+            // reused, since the snapshot; it then stays marked for remeshing
+            Chunk* chunk = GetChunk(chunkX, chunkZ);
+            if (chunk == job->target && chunk->GetRevision() == job->revision) {
+                bool firstMesh = !chunk->HasMesh();
+                chunk->SwapMesh(*job->chunk);
+                chunk->ReportMemory(m_memory);
+                if (firstMesh && m_seenUnmeshed.erase(key)) {
+                    m_lateChunks++;
+                }
+            }
+        }
+    }
 
-    return chunkPtr;
+    // Releases the pooled chunks here rather than at the next drain
+    m_completedJobs.clear();
 }
 
 void World::Update(const Vector3& playerPos, ID3D11Device* device) {
-    int playerChunkX = static_cast<int>(std::floor(playerPos.x / CHUNK_SIZE));
-    int playerChunkZ = static_cast<int>(std::floor(playerPos.z / CHUNK_SIZE));
+    int playerChunkX = static_cast<int>(std::floor(playerPos.x)) >> DefaultChunkShape::SizeShift;
+    int playerChunkZ = static_cast<int>(std::floor(playerPos.z)) >> DefaultChunkShape::SizeShift;
+    m_playerChunkX = playerChunkX;
+    m_playerChunkZ = playerChunkZ;
+    m_frameIndex++;
+    m_chunks.Recenter(playerChunkX, playerChunkZ);
+
+    // Edits from other threads land before this update's meshing
+    m_editQueue.TakeAll(m_queuedEdits);
+    for (const BlockEdit& edit : m_queuedEdits) {
+        SetBlock(edit.x, edit.y, edit.z, edit.type);
+    }
+    m_queuedEditsApplied += m_queuedEdits.size();
+
+    // Load, mesh and upload chunks around the player, nearest and in view
+    // first, each stage within its per-frame time budget
+    m_scheduler.Plan(playerChunkX, playerChunkZ, m_viewDirection, m_playerVelocity, m_renderDistance, &m_tickets);
+
+    // With worker threads the budgets only cover handing out jobs; without,
+    // the jobs run inside Run and the budgets cover the work itself.
+    // Finished jobs are collected after each stage so a chunk generated
+    // this update can be meshed in the same update.
+    CollectCompletedJobs();
+    m_scheduler.Run(ChunkScheduler::Generate, [&](int chunkX, int chunkZ) {
+        return StartChunkLoad(chunkX, chunkZ);
+    });
+    CollectCompletedJobs();
+
+    m_scheduler.Run(ChunkScheduler::Mesh, [&](int chunkX, int chunkZ) {
+        Chunk* chunk = GetChunk(chunkX, chunkZ);
+        return chunk && StartChunkMesh(chunk);
+    });
+    CollectCompletedJobs();
+
+    // Headless runs (benchmarks) have no device
+    if (device) {
+        m_scheduler.Run(ChunkScheduler::Upload, [&](int chunkX, int chunkZ) {
+            Chunk* chunk = GetChunk(chunkX, chunkZ);
+            if (!chunk || chunk->NeedsMeshUpdate() || !chunk->NeedsBufferUpdate()) {
+                return false;
+            }
+            chunk->UpdateBuffer(device);
+            chunk->ReportMemory(m_memory);
+            return true;
+        });
+    }
 
-    // Load chunks around player
-    for (int dx = -m_renderDistance; dx <= m_renderDistance; dx++) {
-        for (int dz = -m_renderDistance; dz <= m_renderDistance; dz++) {
-            int chunkX = playerChunkX + dx;
-            int chunkZ = playerChunkZ + dz;
+    // Unload chunks no observer wants, sooner behind the player's direction
+    // of travel
+    std::vector<std::pair<int, int>> chunksToRemove;
+    m_chunks.ForEach([&](Chunk* chunk) {
+        if (!ShouldKeepChunk(chunk->GetChunkX(), chunk->GetChunkZ())) {
+            chunksToRemove.push_back(std::make_pair(chunk->GetChunkX(), chunk->GetChunkZ()));
+        }
+    });
 
-            Chunk* chunk = GetOrCreateChunk(chunkX, chunkZ);
+    for (const auto& key : chunksToRemove) {
+        ChunkPool::Handle chunk = m_chunks.Remove(key.first, key.second);
+        chunk->WithdrawMemory(m_memory);
+        m_coldCache.Store(*chunk);
+    }
+
+    UpdateVisibility(playerPos);
+    EnforceMemoryBudget(playerChunkX, playerChunkZ);
+    CountPendingWork(device != nullptr);
+    m_published.Publish(m_chunks, m_memory);
+    m_changes.Publish();
+}
 
-            // Always update buffer if needed (including first creation)
-            if (chunk->NeedsMeshUpdate()) {
-                chunk->GenerateMesh();
+void World::CountPendingWork(bool hasDevice) {
+    size_t pending[ChunkScheduler::StageCount] = {};
+    for (const auto& coord : m_scheduler.GetOrder()) {
+        const Chunk* chunk = GetChunk(coord.first, coord.second);
+        if (!chunk) {
+            if (!m_budgetEvicted.count(coord)) pending[ChunkScheduler::Generate]++;
+        } else if (chunk->NeedsMeshUpdate()) {
+            pending[ChunkScheduler::Mesh]++;
+        } else if (hasDevice && chunk->NeedsBufferUpdate()) {
+            pending[ChunkScheduler::Upload]++;
+        }
+    }
+    for (int stage = 0; stage < ChunkScheduler::StageCount; stage++) {
+        m_scheduler.SetPending(static_cast<ChunkScheduler::Stage>(stage), pending[stage]);
+    }
+}
+
+bool World::IsAreaReady(const Vector3& position, int radius, bool requireUpload) const {
+    int centerX = static_cast<int>(std::floor(position.x)) >> DefaultChunkShape::SizeShift;
+    int centerZ = static_cast<int>(std::floor(position.z)) >> DefaultChunkShape::SizeShift;
+    for (int chunkX = centerX - radius; chunkX <= centerX + radius; chunkX++) {
+        for (int chunkZ = centerZ - radius; chunkZ <= centerZ + radius; chunkZ++) {
+            const Chunk* chunk = GetChunk(chunkX, chunkZ);
+            if (!chunk || !chunk->HasMesh() || (requireUpload && chunk->NeedsBufferUpdate())) {
+                return false;
             }
+        }
+    }
+    return true;
+}
 
-            // Update GPU buffers (this checks internally if needed)
-            chunk->UpdateBuffer(device);
+void World::UpdateVisibility(const Vector3& playerPos) {
+    Vector3 forward(m_viewDirection.x, 0.0f, m_viewDirection.z);
+    float forwardLength = forward.length();
+    bool lookingVertically = forwardLength < 0.1f;
+    if (!lookingVertically) {
+        forward = forward / forwardLength;
+    }
+
+    auto isInView = [&](int chunkX, int chunkZ) {
+        Vector3 toChunk((chunkX + 0.5f) * CHUNK_SIZE - playerPos.x, 0.0f, (chunkZ + 0.5f) * CHUNK_SIZE - playerPos.z);
+        float distance = toChunk.length();
+        return lookingVertically || distance < CHUNK_SIZE * 1.5f || toChunk.dot(forward) > distance * kVisibleConeCos;
+    };
+
+    m_chunks.ForEach([&](Chunk* chunk) {
+        if (isInView(chunk->GetChunkX(), chunk->GetChunkZ())) {
+            chunk->SetLastVisibleFrame(m_frameIndex);
+        }
+    });
+
+    // Chunks in view within the render distance with nothing to draw yet
+    // are holes in the world; remember them to count those meshed late
+    int playerChunkX = static_cast<int>(std::floor(playerPos.x)) >> DefaultChunkShape::SizeShift;
+    int playerChunkZ = static_cast<int>(std::floor(playerPos.z)) >> DefaultChunkShape::SizeShift;
+    m_visibleUnmeshed = 0;
+    for (const auto& coord : m_scheduler.GetOrder()) {
+        int dx = coord.first - playerChunkX;
+        int dz = coord.second - playerChunkZ;
+        if (dx * dx + dz * dz > m_renderDistance * m_renderDistance || !isInView(coord.first, coord.second)) {
+            continue;
+        }
+        const Chunk* chunk = GetChunk(coord.first, coord.second);
+        if (!chunk || !chunk->HasMesh()) {
+            m_visibleUnmeshed++;
+            m_seenUnmeshed.insert(coord);
         }
     }
+    for (auto it = m_seenUnmeshed.begin(); it != m_seenUnmeshed.end();) {
+        it = m_scheduler.ShouldKeep(it->first, it->second, kUnloadMargin) ? std::next(it) : m_seenUnmeshed.erase(it);
+    }
+}
 
-    // Unload distant chunks
-    std::vector<std::pair<int, int>> chunksToRemove;
-    for (auto& pair : m_chunks) {
-        int chunkX = pair.first.first;
-        int chunkZ = pair.first.second;
+void World::EnforceMemoryBudget(int playerChunkX, int playerChunkZ) {
+    m_memory.Set(MemoryCategory::ColdCache, m_coldCache.GetStats().byteCount);
 
-        int dx = chunkX - playerChunkX;
-        int dz = chunkZ - playerChunkZ;
+    auto distanceTo = [playerChunkX, playerChunkZ](const std::pair<int, int>& key) {
+        return std::max(std::abs(key.first - playerChunkX), std::abs(key.second - playerChunkZ));
+    };
 
-        if (std::abs(dx) > m_renderDistance + 2 || std::abs(dz) > m_renderDistance + 2) {
-            chunksToRemove.push_back(pair.first);
+    if (!m_memory.IsOverBudget()) {
+        // Drop keys that left the window, then let the nearest evicted chunks back in
+        for (auto it = m_budgetEvicted.begin(); it != m_budgetEvicted.end();) {
+            it = distanceTo(*it) > m_renderDistance ? m_budgetEvicted.erase(it) : std::next(it);
         }
+        if (m_memory.HasHeadroom(kBudgetHeadroom)) {
+            for (int i = 0; i < kBudgetReadmitPerUpdate && !m_budgetEvicted.empty(); i++) {
+                auto nearest = std::min_element(m_budgetEvicted.begin(), m_budgetEvicted.end(),
+                    [&](const std::pair<int, int>& a, const std::pair<int, int>& b) { return distanceTo(a) < distanceTo(b); });
+                m_budgetEvicted.erase(nearest);
+            }
+        }
+        return;
     }
 
-    for (const auto& key : chunksToRemove) {
-        m_chunks.erase(key);
+    // Least recently visible first, farthest first among equals
+    struct Candidate {
+        std::pair<int, int> key;
+        uint64_t lastVisibleFrame;
+        int distance;
+    };
+
+    std::vector<Candidate> candidates;
+    candidates.reserve(m_chunks.GetCount());
+    m_chunks.ForEach([&](Chunk* chunk) {
+        auto key = std::make_pair(chunk->GetChunkX(), chunk->GetChunkZ());
+        candidates.push_back({ key, chunk->GetLastVisibleFrame(), distanceTo(key) });
+    });
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        if (a.lastVisibleFrame != b.lastVisibleFrame) return a.lastVisibleFrame < b.lastVisibleFrame;
+        return a.distance > b.distance;
+    });
+
+    // CPU mesh copies are only needed by renderers that gather them every frame
+    if (!m_cpuMeshesRequired) {
+        for (const Candidate& candidate : candidates) {
+            if (!m_memory.IsOverBudget()) return;
+            Chunk* chunk = GetChunk(candidate.key.first, candidate.key.second);
+            if (chunk->HasCpuMesh() && !chunk->NeedsBufferUpdate()) {
+                chunk->ReleaseCpuMesh();
+                chunk->ReportMemory(m_memory);
+                m_cpuMeshReleases++;
+            }
+        }
+    }
+
+    // Then whole chunks, never the ones around the player
+    for (const Candidate& candidate : candidates) {
+        if (!m_memory.IsOverBudget()) break;
+        if (candidate.distance <= 1) continue;
+
+        ChunkPool::Handle chunk = m_chunks.Remove(candidate.key.first, candidate.key.second);
+        chunk->WithdrawMemory(m_memory);
+        m_coldCache.Store(*chunk);
+        m_budgetEvicted.insert(candidate.key);
+        m_budgetEvictions++;
+        m_memory.Set(MemoryCategory::ColdCache, m_coldCache.GetStats().byteCount);
     }
 }
 
 void World::Render(ID3D11DeviceContext* context) {
-    for (auto& pair : m_chunks) {
-        pair.second->Render(context);
-    }
+    m_chunks.ForEach([&](Chunk* chunk) {
+        if (IsInRenderDistance(chunk)) {
+            chunk->Render(context);
+        }
+    });
 }
 
 void World::RenderTransparent(ID3D11DeviceContext* context, const Vector3& cameraPos) {
@@ -102,16 +437,18 @@ void World::RenderTransparent(ID3D11DeviceContext* context, const Vector3& camer
     };
 
     std::vector<ChunkEntry> entries;
-    entries.reserve(m_chunks.size());
+    entries.reserve(m_chunks.GetCount());
 
-    for (const auto& pair : m_chunks) {
-        Chunk* chunk = pair.second.get();
+    m_chunks.ForEach([&](Chunk* chunk) {
+        if (!IsInRenderDistance(chunk)) {
+            return;
+        }
         Vector3 chunkPos = chunk->GetWorldPosition();
         Vector3 center(chunkPos.x + CHUNK_SIZE * 0.5f, CHUNK_HEIGHT * 0.5f, chunkPos.z + CHUNK_SIZE * 0.5f);
         Vector3 delta = center - cameraPos;
         float distSq = delta.x * delta.x + delta.y * delta.y + delta.z * delta.z;
         entries.push_back({ chunk, distSq });
-    }
+    });
 
     std::sort(entries.begin(), entries.end(),
               [](const ChunkEntry& a, const ChunkEntry& b) { return a.distanceSq > b.distanceSq; });
@@ -129,9 +466,9 @@ Block World::GetBlock(int worldX, int worldY, int worldZ) const {
     int chunkX, chunkZ, localX, localZ;
     GetChunkAndLocalCoords(worldX, worldZ, chunkX, chunkZ, localX, localZ);
 
-    auto it = m_chunks.find(std::make_pair(chunkX, chunkZ));
-    if (it != m_chunks.end()) {
-        return it->second->GetBlock(localX, worldY, localZ);
+    const Chunk* chunk = GetChunk(chunkX, chunkZ);
+    if (chunk) {
+        return chunk->GetBlock(localX, worldY, localZ);
     }
 
     return Block(BlockType::Air);
@@ -147,23 +484,378 @@ void World::SetBlock(int worldX, int worldY, int worldZ, BlockType type) {
 
     Chunk* chunk = GetChunk(chunkX, chunkZ);
     if (chunk) {
+        BlockType oldType = chunk->GetBlock(localX, worldY, localZ).type;
+        if (oldType == type) {
+            return;
+        }
         chunk->SetBlock(localX, worldY, localZ, type);
+        chunk->SetModified(true);
+        m_changes.Record({ worldX, worldY, worldZ, oldType, type });
+
+        // Faces against an edited border belong to the neighbor's mesh
+        if (localX == 0) MarkForMeshUpdate(chunkX - 1, chunkZ);
+        if (localX == CHUNK_SIZE - 1) MarkForMeshUpdate(chunkX + 1, chunkZ);
+        if (localZ == 0) MarkForMeshUpdate(chunkX, chunkZ - 1);
+        if (localZ == CHUNK_SIZE - 1) MarkForMeshUpdate(chunkX, chunkZ + 1);
+    }
+}
+
+void World::MarkForMeshUpdate(int chunkX, int chunkZ) {
+    Chunk* chunk = GetChunk(chunkX, chunkZ);
+    if (chunk) {
+        chunk->MarkForMeshUpdate();
+    }
+}
+
+void World::MarkNeighborsForMeshUpdate(int chunkX, int chunkZ) {
+    for (const auto& offset : kNeighborOffsets) {
+        MarkForMeshUpdate(chunkX + offset.dx, chunkZ + offset.dz);
+    }
+}
+
+template <typename Fn>
+void World::EditChunks(int minX, int minY, int minZ, int maxX, int maxY, int maxZ, Fn&& editChunk) {
+    minY = std::max(minY, 0);
+    maxY = std::min(maxY, CHUNK_HEIGHT - 1);
+    if (minX > maxX || minY > maxY || minZ > maxZ) {
+        return;
+    }
+
+    std::set<std::pair<int, int>> edited;
+    std::set<std::pair<int, int>> neighbors;
+    for (int chunkX = minX >> DefaultChunkShape::SizeShift; chunkX <= maxX >> DefaultChunkShape::SizeShift; chunkX++) {
+        for (int chunkZ = minZ >> DefaultChunkShape::SizeShift; chunkZ <= maxZ >> DefaultChunkShape::SizeShift; chunkZ++) {
+            Chunk* chunk = GetChunk(chunkX, chunkZ);
+            if (!chunk) {
+                continue;
+            }
+            int originX = chunkX * CHUNK_SIZE;
+            int originZ = chunkZ * CHUNK_SIZE;
+            int localMinX = std::max(minX - originX, 0);
+            int localMinZ = std::max(minZ - originZ, 0);
+            int localMaxX = std::min(maxX - originX, CHUNK_SIZE - 1);
+            int localMaxZ = std::min(maxZ - originZ, CHUNK_SIZE - 1);
+            if (!editChunk(chunk, originX, originZ, localMinX, minY, localMinZ, localMaxX, maxY, localMaxZ)) {
+                continue;
+            }
+            chunk->SetModified(true);
+            chunk->ReportMemory(m_memory);
+            edited.insert(std::make_pair(chunkX, chunkZ));
+
+            // Faces against an edited border belong to the neighbor's mesh
+            if (localMinX == 0) neighbors.insert(std::make_pair(chunkX - 1, chunkZ));
+            if (localMaxX == CHUNK_SIZE - 1) neighbors.insert(std::make_pair(chunkX + 1, chunkZ));
+            if (localMinZ == 0) neighbors.insert(std::make_pair(chunkX, chunkZ - 1));
+            if (localMaxZ == CHUNK_SIZE - 1) neighbors.insert(std::make_pair(chunkX, chunkZ + 1));
+        }
+    }
+
+    for (const auto& key : neighbors) {
+        Chunk* chunk = GetChunk(key.first, key.second);
+        if (chunk && !edited.count(key)) {
+            chunk->MarkForMeshUpdate();
+        }
+    }
+}
+
+template <typename Fn>
+void World::EditBlocks(int minX, int minY, int minZ, int maxX, int maxY, int maxZ, Fn&& typeAt) {
+    EditChunks(minX, minY, minZ, maxX, maxY, maxZ,
+        [&](Chunk* chunk, int originX, int originZ, int x0, int y0, int z0, int x1, int y1, int z1) {
+            return chunk->EditBox(x0, y0, z0, x1, y1, z1, [&](int x, int y, int z, BlockType oldType) {
+                BlockType newType = typeAt(originX + x, y, originZ + z, oldType);
+                if (newType != oldType) {
+                    m_changes.Record({ originX + x, y, originZ + z, oldType, newType });
+                }
+                return newType;
+            });
+        });
+}
+
+void World::FillBox(int minX, int minY, int minZ, int maxX, int maxY, int maxZ, BlockType type) {
+    // Subscribers need every old type, so they get the per-block path
+    if (m_changes.GetListenerCount() > 0) {
+        EditBlocks(minX, minY, minZ, maxX, maxY, maxZ, [type](int, int, int, BlockType) { return type; });
+        return;
     }
+    EditChunks(minX, minY, minZ, maxX, maxY, maxZ,
+        [type](Chunk* chunk, int, int, int x0, int y0, int z0, int x1, int y1, int z1) {
+            return chunk->FillBox(x0, y0, z0, x1, y1, z1, type);
+        });
+}
+
+void World::ReplaceInBox(int minX, int minY, int minZ, int maxX, int maxY, int maxZ, BlockType from, BlockType to) {
+    if (m_changes.GetListenerCount() > 0) {
+        EditBlocks(minX, minY, minZ, maxX, maxY, maxZ, [from, to](int, int, int, BlockType oldType) {
+            return oldType == from ? to : oldType;
+        });
+        return;
+    }
+    EditChunks(minX, minY, minZ, maxX, maxY, maxZ,
+        [from, to](Chunk* chunk, int, int, int x0, int y0, int z0, int x1, int y1, int z1) {
+            return chunk->ReplaceInBox(x0, y0, z0, x1, y1, z1, from, to);
+        });
+}
+
+void World::FillSphere(int centerX, int centerY, int centerZ, int radius, BlockType type) {
+    if (m_changes.GetListenerCount() == 0) {
+        EditChunks(centerX - radius, centerY - radius, centerZ - radius, centerX + radius, centerY + radius, centerZ + radius,
+            [=](Chunk* chunk, int originX, int originZ, int, int, int, int, int, int) {
+                return chunk->FillSphere(centerX - originX, centerY, centerZ - originZ, radius, type);
+            });
+        return;
+    }
+    int radiusSq = radius * radius;
+    EditBlocks(centerX - radius, centerY - radius, centerZ - radius, centerX + radius, centerY + radius, centerZ + radius,
+        [=](int x, int y, int z, BlockType oldType) {
+            int dx = x - centerX;
+            int dy = y - centerY;
+            int dz = z - centerZ;
+            return dx * dx + dy * dy + dz * dz <= radiusSq ? type : oldType;
+        });
+}
+
+void World::Paste(const BlockBuffer& buffer, int originX, int originY, int originZ, bool skipAir) {
+    if (m_changes.GetListenerCount() == 0) {
+        EditChunks(originX, originY, originZ,
+                   originX + buffer.sizeX - 1, originY + buffer.sizeY - 1, originZ + buffer.sizeZ - 1,
+            [&](Chunk* chunk, int chunkOriginX, int chunkOriginZ, int, int, int, int, int, int) {
+                return chunk->Paste(buffer, originX - chunkOriginX, originY, originZ - chunkOriginZ, skipAir);
+            });
+        return;
+    }
+    EditBlocks(originX, originY, originZ,
+               originX + buffer.sizeX - 1, originY + buffer.sizeY - 1, originZ + buffer.sizeZ - 1,
+        [&](int x, int y, int z, BlockType oldType) {
+            BlockType type = buffer.Get(x - originX, y - originY, z - originZ);
+            return skipAir && type == BlockType::Air ? oldType : type;
+        });
+}
+
+template <typename Fn>
+void World::ForEachSectionWithType(BlockType type, int minX, int minY, int minZ, int maxX, int maxY, int maxZ, Fn&& fn) const {
+    minY = std::max(minY, 0);
+    maxY = std::min(maxY, CHUNK_HEIGHT - 1);
+    if (minX > maxX || minY > maxY || minZ > maxZ) {
+        return;
+    }
+
+    for (int chunkX = minX >> DefaultChunkShape::SizeShift; chunkX <= maxX >> DefaultChunkShape::SizeShift; chunkX++) {
+        for (int chunkZ = minZ >> DefaultChunkShape::SizeShift; chunkZ <= maxZ >> DefaultChunkShape::SizeShift; chunkZ++) {
+            const Chunk* chunk = GetChunk(chunkX, chunkZ);
+            if (!chunk) {
+                continue;
+            }
+            int originX = chunkX * CHUNK_SIZE;
+            int originZ = chunkZ * CHUNK_SIZE;
+            int sectionMinX = std::max(minX - originX, 0) >> SECTION_SHIFT;
+            int sectionMinZ = std::max(minZ - originZ, 0) >> SECTION_SHIFT;
+            int sectionMaxX = std::min(maxX - originX, CHUNK_SIZE - 1) >> SECTION_SHIFT;
+            int sectionMaxZ = std::min(maxZ - originZ, CHUNK_SIZE - 1) >> SECTION_SHIFT;
+            for (int sectionY = minY >> SECTION_SHIFT; sectionY <= maxY >> SECTION_SHIFT; sectionY++) {
+                for (int sectionX = sectionMinX; sectionX <= sectionMaxX; sectionX++) {
+                    for (int sectionZ = sectionMinZ; sectionZ <= sectionMaxZ; sectionZ++) {
+                        const ChunkSection& section = chunk->GetSection(Chunk::GetSectionIndex(sectionX, sectionY, sectionZ));
+                        if (section.Contains(type)) {
+                            fn(section, originX + sectionX * SECTION_SIZE, sectionY * SECTION_SIZE,
+                               originZ + sectionZ * SECTION_SIZE);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+bool World::FindNearest(BlockType type, int originX, int originY, int originZ, int radius,
+                        int& foundX, int& foundY, int& foundZ) const {
+    struct Candidate {
+        int distanceSq;
+        const ChunkSection* section;
+        int baseX, baseY, baseZ;
+    };
+    std::vector<Candidate> candidates;
+    int radiusSq = radius * radius;
+    ForEachSectionWithType(type, originX - radius, originY - radius, originZ - radius,
+                           originX + radius, originY + radius, originZ + radius,
+        [&](const ChunkSection& section, int baseX, int baseY, int baseZ) {
+            int distanceSq = DistanceSqToSection(originX, originY, originZ, baseX, baseY, baseZ);
+            if (distanceSq <= radiusSq) {
+                candidates.push_back({ distanceSq, &section, baseX, baseY, baseZ });
+            }
+        });
+    std::sort(candidates.begin(), candidates.end(),
+        [](const Candidate& a, const Candidate& b) { return a.distanceSq < b.distanceSq; });
+
+    // Nearest sections first; stop once none can hold a closer block
+    int bestSq = radiusSq + 1;
+    for (const Candidate& candidate : candidates) {
+        if (candidate.distanceSq >= bestSq) {
+            break;
+        }
+        if (candidate.section->IsUniform()) {
+            // All of it is the type, so the nearest point of the section wins
+            foundX = std::min(std::max(originX, candidate.baseX), candidate.baseX + SECTION_MASK);
+            foundY = std::min(std::max(originY, candidate.baseY), candidate.baseY + SECTION_MASK);
+            foundZ = std::min(std::max(originZ, candidate.baseZ), candidate.baseZ + SECTION_MASK);
+            bestSq = candidate.distanceSq;
+            continue;
+        }
+        for (int x = 0; x < SECTION_SIZE; x++) {
+            int dx = candidate.baseX + x - originX;
+            for (int y = 0; y < SECTION_SIZE; y++) {
+                int dy = candidate.baseY + y - originY;
+                for (int z = 0; z < SECTION_SIZE; z++) {
+                    int dz = candidate.baseZ + z - originZ;
+                    int distanceSq = dx * dx + dy * dy + dz * dz;
+                    if (distanceSq < bestSq && candidate.section->Get(x, y, z) == type) {
+                        foundX = candidate.baseX + x;
+                        foundY = candidate.baseY + y;
+                        foundZ = candidate.baseZ + z;
+                        bestSq = distanceSq;
+                    }
+                }
+            }
+        }
+    }
+    return bestSq <= radiusSq;
+}
+
+void World::ForEachOfType(BlockType type, int originX, int originY, int originZ, int radius,
+                          const std::function<void(int, int, int)>& fn) const {
+    int radiusSq = radius * radius;
+    ForEachSectionWithType(type, originX - radius, originY - radius, originZ - radius,
+                           originX + radius, originY + radius, originZ + radius,
+        [&](const ChunkSection& section, int baseX, int baseY, int baseZ) {
+            if (DistanceSqToSection(originX, originY, originZ, baseX, baseY, baseZ) > radiusSq) {
+                return;
+            }
+            for (int x = 0; x < SECTION_SIZE; x++) {
+                int dx = baseX + x - originX;
+                for (int y = 0; y < SECTION_SIZE; y++) {
+                    int dy = baseY + y - originY;
+                    for (int z = 0; z < SECTION_SIZE; z++) {
+                        int dz = baseZ + z - originZ;
+                        if (dx * dx + dy * dy + dz * dz <= radiusSq && section.Get(x, y, z) == type) {
+                            fn(baseX + x, baseY + y, baseZ + z);
+                        }
+                    }
+                }
+            }
+        });
+}
+
+BlockState World::GetBlockState(int worldX, int worldY, int worldZ) const {
+    if (worldY < 0 || worldY >= CHUNK_HEIGHT) {
+        return 0;
+    }
+
+    int chunkX, chunkZ, localX, localZ;
+    GetChunkAndLocalCoords(worldX, worldZ, chunkX, chunkZ, localX, localZ);
+
+    const Chunk* chunk = GetChunk(chunkX, chunkZ);
+    if (chunk) {
+        return chunk->GetBlockState(localX, worldY, localZ);
+    }
+
+    return 0;
+}
+
+void World::SetBlockState(int worldX, int worldY, int worldZ, BlockState state) {
+    if (worldY < 0 || worldY >= CHUNK_HEIGHT) {
+        return;
+    }
+
+    int chunkX, chunkZ, localX, localZ;
+    GetChunkAndLocalCoords(worldX, worldZ, chunkX, chunkZ, localX, localZ);
+
+    Chunk* chunk = GetChunk(chunkX, chunkZ);
+    if (chunk && chunk->SetBlockState(localX, worldY, localZ, state)) {
+        chunk->SetModified(true);
+    }
+}
+
+BlockAccessor World::GetRegion(int worldX, int worldZ) const {
+    int chunkX, chunkZ, localX, localZ;
+    GetChunkAndLocalCoords(worldX, worldZ, chunkX, chunkZ, localX, localZ);
+    return BlockAccessor(chunkX, chunkZ, [this](int x, int z) { return FindChunk(x, z); });
 }
 
 int World::GetTerrainHeight(int worldX, int worldZ) const {
+    int chunkX, chunkZ, localX, localZ;
+    GetChunkAndLocalCoords(worldX, worldZ, chunkX, chunkZ, localX, localZ);
+
+    // Loaded chunks know their surface; only unloaded ones need the noise
+    const Chunk* chunk = GetChunk(chunkX, chunkZ);
+    if (chunk) {
+        return chunk->GetHeight(localX, localZ);
+    }
+
     return m_terrainGenerator.GetTerrainHeight(worldX, worldZ);
 }
 
+int World::GetGroundHeight(int worldX, int worldZ, int fromY) const {
+    if (fromY < 0) {
+        return -1;
+    }
+    fromY = std::min(fromY, CHUNK_HEIGHT - 1);
+
+    int chunkX, chunkZ, localX, localZ;
+    GetChunkAndLocalCoords(worldX, worldZ, chunkX, chunkZ, localX, localZ);
+    const Chunk* chunk = GetChunk(chunkX, chunkZ);
+    if (!chunk) {
+        // Generated terrain has nothing solid above its surface but trees
+        int height = m_terrainGenerator.GetTerrainHeight(worldX, worldZ);
+        return height <= fromY ? height : -1;
+    }
+
+    // The heightmap answers unless something solid is overhead
+    int height = chunk->GetHeight(localX, localZ);
+    if (height <= fromY) {
+        return height;
+    }
+    for (int y = fromY; y >= 0; y--) {
+        if (BlockDatabase::IsSolid(chunk->GetBlockType(localX, y, localZ))) {
+            return y;
+        }
+    }
+    return -1;
+}
+
 World::DebugStats World::GetDebugStats() const {
     DebugStats stats;
-    stats.chunkCount = static_cast<int>(m_chunks.size());
-
-    for (const auto& pair : m_chunks) {
-        const Chunk* chunk = pair.second.get();
+    stats.chunkCount = static_cast<int>(m_chunks.GetCount());
+    stats.chunkGridOverflow = m_chunks.GetOverflowCount();
+    stats.scheduler = m_scheduler.GetStats();
+    stats.workerThreads = m_workers.GetThreadCount();
+    stats.meshMode = m_meshMode;
+    stats.jobsInFlight = m_workers.GetInFlightCount();
+    stats.prefetchLeadChunks = m_scheduler.GetLeadChunks();
+    stats.observerCount = m_tickets.GetTicketCount();
+    stats.ticketedChunks = m_tickets.GetHeldChunkCount();
+    stats.queuedEditsApplied = m_queuedEditsApplied;
+    stats.blockChangesPublished = m_changes.GetPublishedCount();
+    stats.published = m_published.GetStats();
+    stats.visibleUnmeshedChunks = m_visibleUnmeshed;
+    stats.chunksVisibleBeforeMeshed = m_lateChunks;
+
+    ChunkPool::Stats poolStats = m_chunkPool.GetStats();
+    stats.chunkPoolHits = poolStats.hits;
+    stats.chunkPoolMisses = poolStats.misses;
+    stats.chunkPoolFree = poolStats.freeCount;
+    stats.chunkPoolSlabs = poolStats.slabCount;
+    stats.coldCache = m_coldCache.GetStats();
+    stats.memory = m_memory;
+    stats.cpuMeshReleases = m_cpuMeshReleases;
+    stats.budgetEvictions = m_budgetEvictions;
+
+    m_chunks.ForEach([&](const Chunk* chunk) {
+        if (IsInRenderDistance(chunk)) {
+            stats.renderedChunkCount++;
+        }
         stats.solidIndexCount += static_cast<uint64_t>(chunk->GetSolidIndexCount());
         stats.transparentIndexCount += static_cast<uint64_t>(chunk->GetTransparentIndexCount());
-    }
+    });
 
     return stats;
 }
@@ -172,21 +864,12 @@ void World::GatherSolidMesh(std::vector<Vertex>& vertices, std::vector<uint32_t>
     vertices.clear();
     indices.clear();
 
-    for (const auto& pair : m_chunks) {
-        const Chunk* chunk = pair.second.get();
-        const auto& chunkVerts = chunk->GetSolidVertices();
-        const auto& chunkIndices = chunk->GetSolidIndices();
-        if (chunkVerts.empty() || chunkIndices.empty()) {
-            continue;
-        }
-
-        uint32_t baseIndex = static_cast<uint32_t>(vertices.size());
-        vertices.insert(vertices.end(), chunkVerts.begin(), chunkVerts.end());
-        indices.reserve(indices.size() + chunkIndices.size());
-        for (uint32_t idx : chunkIndices) {
-            indices.push_back(baseIndex + idx);
+    m_chunks.ForEach([&](const Chunk* chunk) {
+        if (!IsInRenderDistance(chunk)) {
+            return;
         }
-    }
+        chunk->AppendSolidMesh(vertices, indices);
+    });
 }
 
 void World::GatherTransparentMesh(const Vector3& cameraPos, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) const {
@@ -194,38 +877,29 @@ void World::GatherTransparentMesh(const Vector3& cameraPos, std::vector<Vertex>&
     indices.clear();
 
     struct ChunkEntry {
-        Chunk* chunk;
+        const Chunk* chunk;
         float distanceSq;
     };
 
     std::vector<ChunkEntry> entries;
-    entries.reserve(m_chunks.size());
+    entries.reserve(m_chunks.GetCount());
 
-    for (const auto& pair : m_chunks) {
-        Chunk* chunk = pair.second.get();
+    m_chunks.ForEach([&](const Chunk* chunk) {
+        if (!IsInRenderDistance(chunk)) {
+            return;
+        }
         Vector3 chunkPos = chunk->GetWorldPosition();
         Vector3 center(chunkPos.x + CHUNK_SIZE * 0.5f, CHUNK_HEIGHT * 0.5f, chunkPos.z + CHUNK_SIZE * 0.5f);
         Vector3 delta = center - cameraPos;
         float distSq = delta.x * delta.x + delta.y * delta.y + delta.z * delta.z;
         entries.push_back({ chunk, distSq });
-    }
+    });
 
     std::sort(entries.begin(), entries.end(),
               [](const ChunkEntry& a, const ChunkEntry& b) { return a.distanceSq > b.distanceSq; });
 
     for (const auto& entry : entries) {
-        const auto& chunkVerts = entry.chunk->GetTransparentVertices();
-        const auto& chunkIndices = entry.chunk->GetTransparentIndices();
-        if (chunkVerts.empty() || chunkIndices.empty()) {
-            continue;
-        }
-
-        uint32_t baseIndex = static_cast<uint32_t>(vertices.size());
-        vertices.insert(vertices.end(), chunkVerts.begin(), chunkVerts.end());
-        indices.reserve(indices.size() + chunkIndices.size());
-        for (uint32_t idx : chunkIndices) {
-            indices.push_back(baseIndex + idx);
-        }
+        entry.chunk->AppendTransparentMesh(vertices, indices);
     }
 }
 
@@ -234,6 +908,12 @@ bool World::Raycast(const Vector3& origin, const Vector3& direction, float maxDi
     Vector3 pos = origin;
     Vector3 step = direction.normalized() * 0.1f;
 
+    // Consecutive steps almost always stay in the same chunk
+    const Chunk* chunk = nullptr;
+    int currentChunkX = 0;
+    int currentChunkZ = 0;
+    bool haveChunk = false;
+
     for (float dist = 0; dist < maxDistance; dist += 0.1f) {
         pos = pos + step;
 
@@ -241,7 +921,21 @@ bool World::Raycast(const Vector3& origin, const Vector3& direction, float maxDi
         int blockY = static_cast<int>(std::floor(pos.y));
         int blockZ = static_cast<int>(std::floor(pos.z));
 
-        Block block = GetBlock(blockX, blockY, blockZ);
+        int chunkX, chunkZ, localX, localZ;
+        GetChunkAndLocalCoords(blockX, blockZ, chunkX, chunkZ, localX, localZ);
+        if (!haveChunk || chunkX != currentChunkX || chunkZ != currentChunkZ) {
+            chunk = GetChunk(chunkX, chunkZ);
+            currentChunkX = chunkX;
+            currentChunkZ = chunkZ;
+            haveChunk = true;
+        }
+
+        // Anything outside the chunk's occupied range is air
+        if (!chunk || blockY < chunk->GetMinY() || blockY > chunk->GetMaxY()) {
+            continue;
+        }
+
+        Block block = chunk->GetBlock(localX, blockY, localZ);
 
         if (!block.IsAir() && !block.IsTransparent()) {
             hitPos = Vector3(blockX, blockY, blockZ);
@@ -1,21 +1,59 @@
 #pragma once
+#include "BlockAccessor.h"
+#include "BlockEdits.h"
 #include "Chunk.h"
+#include "ChunkGrid.h"
+#include "ChunkPool.h"
+#include "ChunkScheduler.h"
+#include "ChunkTickets.h"
+#include "ChunkCache.h"
+#include "ChunkWorkers.h"
+#include "MemoryTracker.h"
+#include "PublishedChunks.h"
 #include "TerrainGenerator.h"
 #include "MathUtils.h"
-#include <map>
+#include <set>
 #include <memory>
 #include <cstdint>
 #include <vector>
 
 class World {
 public:
-    World(unsigned int seed = 12345);
+    // workerThreads < 0 uses one thread per spare core; 0 generates and
+    // meshes on the thread calling Update
+    World(unsigned int seed = 12345, int workerThreads = -1);
     ~World();
 
     struct DebugStats {
         int chunkCount = 0;
+        // Loaded chunks within the render distance; only these are drawn
+        int renderedChunkCount = 0;
         uint64_t solidIndexCount = 0;
         uint64_t transparentIndexCount = 0;
+        uint64_t chunkPoolHits = 0;
+        uint64_t chunkPoolMisses = 0;
+        size_t chunkPoolFree = 0;
+        size_t chunkPoolSlabs = 0;
+        size_t chunkGridOverflow = 0;
+        ChunkScheduler::Stats scheduler;
+        int workerThreads = 0;
+        MeshMode meshMode = MeshMode::Bitmask;
+        size_t jobsInFlight = 0;
+        int prefetchLeadChunks = 0;
+        // Observers besides the player, and the chunks their tickets hold
+        size_t observerCount = 0;
+        size_t ticketedChunks = 0;
+        uint64_t queuedEditsApplied = 0;
+        uint64_t blockChangesPublished = 0;
+        PublishedChunks::Stats published;
+        // Chunks in view inside the render distance with no mesh yet: now,
+        // and in total (counted once each, when they get their mesh)
+        size_t visibleUnmeshedChunks = 0;
+        uint64_t chunksVisibleBeforeMeshed = 0;
+        ChunkCache::Stats coldCache;
+        MemoryTracker memory;
+        uint64_t cpuMeshReleases = 0;
+        uint64_t budgetEvictions = 0;
     };
 
     void Update(const Vector3& playerPos, ID3D11Device* device);
@@ -23,9 +61,91 @@ public:
     void RenderTransparent(ID3D11DeviceContext* context, const Vector3& cameraPos);
 
     Block GetBlock(int worldX, int worldY, int worldZ) const;
+    // Main thread only; edits to unloaded chunks are dropped
     void SetBlock(int worldX, int worldY, int worldZ, BlockType type);
+    // Bulk edits, in world coordinates with both corners inclusive. They
+    // write straight into chunk storage and mark each touched chunk, and
+    // each neighbor across an edited border, for a single remesh. Parts in
+    // unloaded chunks are dropped, as with SetBlock.
+    void FillBox(int minX, int minY, int minZ, int maxX, int maxY, int maxZ, BlockType type);
+    void ReplaceInBox(int minX, int minY, int minZ, int maxX, int maxY, int maxZ, BlockType from, BlockType to);
+    void FillSphere(int centerX, int centerY, int centerZ, int radius, BlockType type);
+    // skipAir leaves the world's blocks where the buffer holds air
+    void Paste(const BlockBuffer& buffer, int originX, int originY, int originZ, bool skipAir = false);
+
+    // Blocks of one type within radius (a sphere) of a block position, in
+    // loaded chunks. Sections holding none of the type are skipped without
+    // reading their blocks.
+    // The closest one; false if there is none
+    bool FindNearest(BlockType type, int originX, int originY, int originZ, int radius,
+                     int& foundX, int& foundY, int& foundZ) const;
+    // fn(x, y, z) for each of them, in no particular order
+    void ForEachOfType(BlockType type, int originX, int originY, int originZ, int radius,
+                       const std::function<void(int, int, int)>& fn) const;
+    // Any thread; applied in order at the start of the next Update
+    void QueueSetBlock(int worldX, int worldY, int worldZ, BlockType type) {
+        m_editQueue.Push({ worldX, worldY, worldZ, type });
+    }
+    // Every block type change, from SetBlock or the queue, is delivered to
+    // the listeners in one batch at the end of each Update
+    BlockChangeStream::ListenerId SubscribeToChanges(BlockChangeStream::Listener listener) {
+        return m_changes.Subscribe(std::move(listener));
+    }
+    void UnsubscribeFromChanges(BlockChangeStream::ListenerId id) { m_changes.Unsubscribe(id); }
+    BlockState GetBlockState(int worldX, int worldY, int worldZ) const;
+    void SetBlockState(int worldX, int worldY, int worldZ, BlockState state);
+    // Loaded chunk or null; GetRegion pins the 3x3 chunks around a block
+    const Chunk* FindChunk(int chunkX, int chunkZ) const { return m_chunks.Find(chunkX, chunkZ); }
+    BlockAccessor GetRegion(int worldX, int worldZ) const;
+    // For threads other than the one calling Update (generation, meshing,
+    // AI): a PublishedChunks::Reader reads the world as of the end of the
+    // last Update without locks, while Update goes on. Readers hold a
+    // PublishedChunks::Subscription; without any, nothing is published.
+    const PublishedChunks& GetPublishedChunks() const { return m_published; }
+    // Highest solid block of a column, from the chunk heightmap when loaded
     int GetTerrainHeight(int worldX, int worldZ) const;
+    // Highest solid block of a column at or below fromY, or -1 if none:
+    // the ground under something standing beneath a tree or an overhang
+    int GetGroundHeight(int worldX, int worldZ, int fromY) const;
     DebugStats GetDebugStats() const;
+    void SetColdCacheBudget(size_t bytes) { m_coldCache.SetByteBudget(bytes); }
+
+    // Total bytes for block data, meshes and the cold cache (0 = unlimited).
+    // Over budget, CPU mesh copies are dropped first (unless a renderer needs
+    // them), then chunks in least-recently-visible order.
+    void SetMemoryBudget(size_t bytes) { m_memory.SetBudget(bytes); }
+    void SetCpuMeshesRequired(bool required) { m_cpuMeshesRequired = required; }
+    // Switching remeshes every loaded chunk; each keeps drawing its old
+    // mesh until the new one is ready
+    void SetMeshMode(MeshMode mode);
+    MeshMode GetMeshMode() const { return m_meshMode; }
+    void SetViewDirection(const Vector3& forward) { m_viewDirection = forward; }
+    // Recent player velocity in blocks/s, for the prefetch policy
+    void SetPlayerVelocity(const Vector3& velocity) { m_playerVelocity = velocity; }
+    void SetPrefetchPolicy(const ChunkPrefetchPolicy& policy);
+    // In chunks; chunks beyond it (plus the unload margin) unload on the next Update
+    void SetRenderDistance(int distance);
+    int GetRenderDistance() const { return m_renderDistance; }
+    // Per-frame time for generating, meshing and uploading chunks
+    void SetLoadBudget(const ChunkLoadBudget& budget) { m_scheduler.SetBudget(budget); }
+    // False once every chunk in range is generated, meshed and uploaded
+    bool HasPendingWork() const { return m_scheduler.HasPendingWork(); }
+    // Whether every chunk within radius chunks (a square) of a position is
+    // generated and meshed, and uploaded if requireUpload is set
+    bool IsAreaReady(const Vector3& position, int radius, bool requireUpload) const;
+    const ChunkScheduler::Stats& GetLoadStats() const { return m_scheduler.GetStats(); }
+
+    // Observers besides the player (spectator cameras, benchmark probes,
+    // remote players) each hold a load ticket for the chunks within radius
+    // of their position. Chunks wanted by several observers are loaded once
+    // and stay until none wants them. Higher weights load sooner; the
+    // player's own distances count with weight 1. Only the player's render
+    // distance is drawn.
+    using ObserverId = ChunkTickets::TicketId;
+    ObserverId AddObserver(const Vector3& position, int radius, float weight = 1.0f);
+    void MoveObserver(ObserverId id, const Vector3& position);
+    void SetObserverRadius(ObserverId id, int radius) { m_tickets.SetRadius(id, radius); }
+    void RemoveObserver(ObserverId id) { m_tickets.Remove(id); }
     void GatherSolidMesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) const;
     void GatherTransparentMesh(const Vector3& cameraPos, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) const;
 
@@ -33,11 +153,80 @@ public:
                  Vector3& hitPos, Vector3& hitNormal, Block& hitBlock);
 
 private:
-    Chunk* GetChunk(int chunkX, int chunkZ);
-    Chunk* GetOrCreateChunk(int chunkX, int chunkZ);
+    Chunk* GetChunk(int chunkX, int chunkZ) { return m_chunks.Find(chunkX, chunkZ); }
+    const Chunk* GetChunk(int chunkX, int chunkZ) const { return m_chunks.Find(chunkX, chunkZ); }
+    // Loads from the cold cache or queues generation; false if nothing started
+    bool StartChunkLoad(int chunkX, int chunkZ);
+    // Meshes a snapshot padded with the loaded neighbors' border sections
+    bool StartChunkMesh(Chunk* chunk);
+    // No-op for chunks that aren't loaded
+    void MarkForMeshUpdate(int chunkX, int chunkZ);
+    // A chunk that loads hides faces along its neighbors' borders
+    void MarkNeighborsForMeshUpdate(int chunkX, int chunkZ);
+    // editChunk(chunk, originX, originZ, minX, minY, minZ, maxX, maxY, maxZ)
+    // for each loaded chunk the world box overlaps, with the chunk-local part
+    // of the box; returns whether it changed the chunk
+    template <typename Fn>
+    void EditChunks(int minX, int minY, int minZ, int maxX, int maxY, int maxZ, Fn&& editChunk);
+    // typeAt(worldX, worldY, worldZ, oldType) for every loaded block in the
+    // box, recording each change for the change stream
+    template <typename Fn>
+    void EditBlocks(int minX, int minY, int minZ, int maxX, int maxY, int maxZ, Fn&& typeAt);
+    // fn(section, baseX, baseY, baseZ) for each loaded section holding the
+    // type that overlaps the box, with the world position of its corner
+    template <typename Fn>
+    void ForEachSectionWithType(BlockType type, int minX, int minY, int minZ, int maxX, int maxY, int maxZ, Fn&& fn) const;
+    // Near the player (see ChunkScheduler::ShouldKeep) or held by a ticket
+    bool ShouldKeepChunk(int chunkX, int chunkZ) const;
+    // Inserts generated chunks still in range and installs meshes that are
+    // not stale, dropping the rest
+    void CollectCompletedJobs();
+    // Sizes the grid window to the render distance and prefetch lead
+    void UpdateGridWindow();
+    // Chunks kept loaded past the render distance (unload margin, prefetch)
+    // are not drawn
+    bool IsInRenderDistance(const Chunk* chunk) const {
+        int dx = chunk->GetChunkX() - m_playerChunkX;
+        int dz = chunk->GetChunkZ() - m_playerChunkZ;
+        return dx * dx + dz * dz <= m_renderDistance * m_renderDistance;
+    }
     void GetChunkAndLocalCoords(int worldX, int worldZ, int& chunkX, int& chunkZ, int& localX, int& localZ) const;
+    void UpdateVisibility(const Vector3& playerPos);
+    void EnforceMemoryBudget(int playerChunkX, int playerChunkZ);
+    void CountPendingWork(bool hasDevice);
 
-    std::map<std::pair<int, int>, std::unique_ptr<Chunk>> m_chunks;
+    // The pool must outlive the chunks it hands out
+    ChunkPool m_chunkPool;
+    ChunkPool m_snapshotPool;
+    ChunkGrid m_chunks;
+    ChunkCache m_coldCache;
     TerrainGenerator m_terrainGenerator;
+    ChunkScheduler m_scheduler;
+    ChunkTickets m_tickets;
+    // Declared after the pools and generator its jobs use
+    ChunkWorkers m_workers;
+    std::set<std::pair<int, int>> m_generating;
+    std::set<std::pair<int, int>> m_meshing;
+    std::vector<std::unique_ptr<ChunkWorkers::Job>> m_completedJobs;
+    BlockEditQueue m_editQueue;
+    std::vector<BlockEdit> m_queuedEdits;
+    uint64_t m_queuedEditsApplied;
+    BlockChangeStream m_changes;
+    PublishedChunks m_published;
     int m_renderDistance;
+
+    MemoryTracker m_memory;
+    bool m_cpuMeshesRequired;
+    MeshMode m_meshMode;
+    Vector3 m_viewDirection;
+    Vector3 m_playerVelocity;
+    size_t m_visibleUnmeshed;
+    uint64_t m_lateChunks;
+    std::set<std::pair<int, int>> m_seenUnmeshed;
+    int m_playerChunkX, m_playerChunkZ;
+    uint64_t m_frameIndex;
+    uint64_t m_cpuMeshReleases;
+    uint64_t m_budgetEvictions;
+    // Chunks unloaded to meet the budget, kept out until there is headroom
+    std::set<std::pair<int, int>> m_budgetEvicted;
 };
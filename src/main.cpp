@@ -6,15 +6,42 @@
 #include "BlockDatabase.h"
 #include "SoundSystem.h"
 #include "DX12Renderer.h"
+#include "Benchmark.h"
+#include "RenderDistanceTuner.h"
 #include <windows.h>
 #include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <thread>
 #include <vector>
 #include <memory>
 
+namespace {
+    // Chunks around the spawn chunk loaded before the first frame
+    const int kSpawnRingRadius = 1;
+
+    float GetElapsedMs(std::chrono::high_resolution_clock::time_point start) {
+        return std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+}
+
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow)
 {
-    // Initialize block database
-    BlockDatabase::Initialize();
+    // Headless benchmark run: no window or renderer
+    if (lpCmdLine && std::strstr(lpCmdLine, "--benchmark")) {
+        return RunBenchmarks("bench_output.txt") ? 0 : -1;
+    }
+
+    // Frame rate the render distance is tuned for, e.g. --target-fps 144
+    float targetFps = 60.0f;
+    const char* targetFpsArg = lpCmdLine ? std::strstr(lpCmdLine, "--target-fps") : nullptr;
+    if (targetFpsArg) {
+        float parsed = std::strtof(targetFpsArg + std::strlen("--target-fps"), nullptr);
+        if (parsed > 0.0f) targetFps = parsed;
+    }
+
+    auto startTime = std::chrono::high_resolution_clock::now();
 
     // Create window
     Window window(1280, 720, "RTXBlocks - Minecraft-inspired Block Demo");
@@ -23,6 +50,13 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
         return -1;
     }
 
+    // Create the world first and queue the spawn area, so worker threads
+    // generate it while the renderers initialize
+    World world(12345);
+    RenderDistanceTuner distanceTuner(world.GetRenderDistance(), 4, 16, targetFps);
+    const Vector3 spawnPos(0, 0, 0);
+    world.Update(spawnPos, nullptr);
+
     // Create renderer
     Renderer renderer;
     if (!renderer.Initialize(&window)) {
@@ -37,8 +71,16 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
     SoundSystem soundSystem;
     soundSystem.Initialize();
 
-    // Create world
-    World world(12345);
+    // The DX12 path gathers CPU meshes every frame, so they may only be
+    // dropped for memory when rendering through D3D11
+    world.SetCpuMeshesRequired(dx12Ready);
+
+    // Wait only for the spawn chunk and its ring; the rest of the render
+    // distance fills in while the game runs
+    while (!world.IsAreaReady(spawnPos, kSpawnRingRadius, true)) {
+        world.Update(spawnPos, renderer.GetDevice());
+        std::this_thread::yield();
+    }
 
     // Create player - spawn above terrain
     Player player;
@@ -53,8 +95,10 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
     // Create some cows
     std::vector<std::unique_ptr<Mob>> mobs;
     for (int i = 0; i < 5; i++) {
-        auto cow = std::make_unique<Mob>(MobType::Cow,
-                                         Vector3(i * 10.0f - 20.0f, 70.0f, 20.0f));
+        float cowX = i * 10.0f - 20.0f;
+        float cowZ = 20.0f;
+        float cowY = static_cast<float>(world.GetTerrainHeight(static_cast<int>(cowX), static_cast<int>(cowZ)) + 1);
+        auto cow = std::make_unique<Mob>(MobType::Cow, Vector3(cowX, cowY, cowZ));
         cow->CreateMesh(renderer.GetDevice());
         mobs.push_back(std::move(cow));
     }
@@ -75,6 +119,10 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
     int lastWidth = window.GetWidth();
     int lastHeight = window.GetHeight();
 
+    // Cold start timings, logged once each
+    bool loggedFirstFrame = false;
+    bool loggedFullRadius = false;
+
     while (running) {
         // Calculate delta time
         auto currentTime = std::chrono::high_resolution_clock::now();
@@ -124,6 +172,11 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
             }
         }
 
+        // Toggle greedy meshing
+        if (window.WasKeyPressed('G')) {
+            world.SetMeshMode(world.GetMeshMode() == MeshMode::Greedy ? MeshMode::Bitmask : MeshMode::Greedy);
+        }
+
         // Update player
         player.Update(deltaTime, &window, &world, &soundSystem);
 
@@ -145,11 +198,29 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
         }
 
         // Update world (load/unload chunks)
+        world.SetViewDirection(player.GetCamera().GetForward());
+        world.SetPlayerVelocity(player.GetVelocity());
         world.Update(player.GetPosition(), renderer.GetDevice());
+        if (!loggedFullRadius && !world.HasPendingWork()) {
+            char message[128];
+            std::snprintf(message, sizeof(message), "Startup: full render distance (%d) loaded after %.0f ms\n",
+                          world.GetRenderDistance(), GetElapsedMs(startTime));
+            OutputDebugStringA(message);
+            loggedFullRadius = true;
+        }
+
+        // Fit the render distance to the frame time target
+        float loadMs = 0.0f;
+        for (double stageMs : world.GetLoadStats().lastFrameMs) {
+            loadMs += static_cast<float>(stageMs);
+        }
+        if (distanceTuner.Update(deltaTime, loadMs, world.HasPendingWork())) {
+            world.SetRenderDistance(distanceTuner.GetDistance());
+        }
 
         // Update mobs
         for (auto& mob : mobs) {
-            mob->Update(deltaTime);
+            mob->Update(deltaTime, &world);
         }
 
         // Render
@@ -159,6 +230,10 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
             uiInfo.fps = currentFPS;
             uiInfo.showDebug = renderer.IsDebugHUDVisible();
             uiInfo.selectedSlot = player.GetSelectedSlot();
+            uiInfo.renderDistance = distanceTuner.GetDistance();
+            uiInfo.renderDistanceReason = distanceTuner.GetReasonText();
+            uiInfo.frameMs = distanceTuner.GetSmoothedFrameMs();
+            uiInfo.targetFrameMs = distanceTuner.GetTargetMs();
 
             Vector3 hitPos, hitNormal;
             Block hitBlock;
@@ -202,6 +277,16 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
                 debugInfo.loadedChunkCount = worldStats.chunkCount;
                 debugInfo.solidIndexCount = worldStats.solidIndexCount;
                 debugInfo.transparentIndexCount = worldStats.transparentIndexCount;
+                debugInfo.meshMode = GetMeshModeName(worldStats.meshMode);
+                debugInfo.memoryBlockBytes = worldStats.memory.Get(MemoryCategory::BlockData);
+                debugInfo.memoryCpuMeshBytes = worldStats.memory.Get(MemoryCategory::CpuMesh);
+                debugInfo.memoryGpuMeshBytes = worldStats.memory.Get(MemoryCategory::GpuMesh);
+                debugInfo.memoryColdCacheBytes = worldStats.memory.Get(MemoryCategory::ColdCache);
+                debugInfo.memoryBudgetBytes = worldStats.memory.GetBudget();
+                debugInfo.renderDistance = distanceTuner.GetDistance();
+                debugInfo.renderDistanceReason = distanceTuner.GetReasonText();
+                debugInfo.frameMs = distanceTuner.GetSmoothedFrameMs();
+                debugInfo.targetFrameMs = distanceTuner.GetTargetMs();
 
                 // Raycast to find looked-at block
                 Vector3 hitPos, hitNormal;
@@ -226,6 +311,13 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 
             renderer.EndFrame();
         }
+
+        if (!loggedFirstFrame) {
+            char message[128];
+            std::snprintf(message, sizeof(message), "Startup: first frame after %.0f ms\n", GetElapsedMs(startTime));
+            OutputDebugStringA(message);
+            loggedFirstFrame = true;
+        }
     }
 
     return 0;